@@ -78,9 +78,17 @@
 
 // Extended opcodes
 #define MUTEX				0x01
+#define EVENT				0x02
 #define CONDREF_OP			0x12
 #define ARBFIELD_OP			0x13
+#define STALL_OP			0x21
 #define SLEEP_OP			0x22
+#define ACQUIRE_OP			0x23
+#define SIGNAL_OP			0x24
+#define WAIT_OP				0x25
+#define RESET_OP			0x26
+#define RELEASE_OP			0x27
+#define TIMER_OP			0x33
 #define OPREGION			0x80
 #define FIELD				0x81
 #define DEVICE				0x82
@@ -111,6 +119,7 @@
 // Methods
 #define METHOD_ARGC_MASK		0x07
 #define METHOD_SERIALIZED		0x08
+#define METHOD_SYNC_LEVEL_SHIFT		4
 
 
 
@@ -0,0 +1,1426 @@
+
+/*
+ * Lux ACPI Implementation
+ * Copyright (C) 2018 by Omar Mohammad
+ */
+
+/* ACPI Control Method Compiler */
+/* Translates the AML of a control method into a pre-decoded IR once, so that
+ * package lengths, name strings and integer prefixes aren't decoded again every
+ * time the method runs. Anything the compiler doesn't understand makes the
+ * whole method fall back to the AML interpreter in exec.c. */
+
+#include "lai.h"
+
+#define ACPI_IR_WINDOW			64	// realloc()'d, like the namespace
+#define ACPI_INLINE_SIZE		16	// callees up to this many instructions are inlined
+
+typedef struct acpi_compiler_t
+{
+	acpi_irop_t *code;
+	size_t count;
+	size_t allocation;
+
+	size_t stack_size;		// current depth of the operand stack
+	size_t max_stack_size;
+
+	int in_loop;
+	size_t loop_start;		// for Continue, start of the predicate
+} acpi_compiler_t;
+
+acpi_irop_t *acpi_compile_emit(acpi_compiler_t *, uint8_t, int);
+size_t acpi_compile_block(acpi_compiler_t *, uint8_t *, size_t);
+size_t acpi_compile_statement(acpi_compiler_t *, uint8_t *, size_t);
+size_t acpi_compile_term(acpi_compiler_t *, uint8_t *);
+size_t acpi_compile_target(acpi_compiler_t *, uint8_t *);
+size_t acpi_compile_name(acpi_compiler_t *, uint8_t *);
+size_t acpi_compile_operands(acpi_compiler_t *, uint8_t *, size_t);
+int acpi_compile_inline(acpi_compiler_t *, acpi_handle_t *);
+void acpi_compile_fold(acpi_compiler_t *);
+int acpi_compile_fold_op(acpi_irop_t *, size_t, uint8_t *);
+int acpi_compile_prune(acpi_compiler_t *);
+void acpi_compile_compact(acpi_compiler_t *);
+void acpi_compile_fuse(acpi_compiler_t *);
+int acpi_compile_pure(acpi_compiler_t *);
+void acpi_compile_slots(acpi_compiler_t *, acpi_ir_t *);
+size_t acpi_compile_match(acpi_irop_t *, size_t, uint8_t *, acpi_irop_t *);
+char *acpi_compile_path(char *);
+
+// acpi_compile_method(): Compiles a control method into IR
+// Param:	acpi_handle_t *method - method handle
+// Return:	acpi_ir_t * - compiled method, NULL if it must run from AML
+
+acpi_ir_t *acpi_compile_method(acpi_handle_t *method)
+{
+	acpi_context_t *context = acpi_context();
+	acpi_compiler_t compiler;
+	acpi_memset(&compiler, 0, sizeof(acpi_compiler_t));
+
+	compiler.allocation = ACPI_IR_WINDOW;
+	compiler.code = acpi_calloc(sizeof(acpi_irop_t), compiler.allocation);
+
+	// names within the method are relative to the method itself
+	char path_save[ACPI_MAX_NAME];
+	acpi_strcpy(path_save, context->path);
+	acpi_strcpy(context->path, method->path);
+
+	// callees are compiled from within, so this tells recursion apart
+	if(context->compile_nesting < ACPI_INLINE_DEPTH)
+		context->compile_methods[context->compile_nesting] = method->index;
+	context->compile_nesting++;
+
+	size_t size = acpi_compile_block(&compiler, method->pointer, method->size);
+
+	context->compile_nesting--;
+	acpi_strcpy(context->path, path_save);
+
+	if(size != method->size || compiler.max_stack_size > ACPI_IR_MAX_STACK)
+	{
+		// the instructions themselves hold nothing that needs freeing except names
+		while(compiler.count)
+		{
+			compiler.count--;
+			if(compiler.code[compiler.count].name)
+				acpi_free(compiler.code[compiler.count].name);
+		}
+
+		acpi_free(compiler.code);
+		return NULL;
+	}
+
+	acpi_compile_fold(&compiler);
+	acpi_compile_fuse(&compiler);
+
+	acpi_ir_t *ir = acpi_calloc(1, sizeof(acpi_ir_t));
+	ir->count = compiler.count;
+	ir->stack_size = compiler.max_stack_size;
+	ir->code = compiler.code;
+	ir->argc = method->method_flags & METHOD_ARGC_MASK;
+	acpi_compile_slots(&compiler, ir);
+	ir->pure = acpi_compile_pure(&compiler);
+	ir->mutex = method->mutex;
+
+	//acpi_printf("acpi: compiled %s, %d bytes of AML into %d instructions\n", method->path, method->size, ir->count);
+	return ir;
+}
+
+// acpi_compile_cached(): Returns the IR of a method, compiling it the first time
+// Param:	acpi_handle_t *method - method handle
+// Return:	acpi_ir_t * - compiled method, NULL if it must run from AML
+
+acpi_ir_t *acpi_compile_cached(acpi_handle_t *method)
+{
+	acpi_context_t *context;
+	acpi_ir_t *ir;
+
+	// other threads look without the lock, so the IR is only published
+	// once it's complete
+#ifdef ACPI_THREADS
+	ir = __atomic_load_n(&method->method_ir, __ATOMIC_ACQUIRE);
+	if(ir || __atomic_load_n(&method->method_ir_failed, __ATOMIC_RELAXED))
+		return ir;
+#else
+	if(method->method_ir || method->method_ir_failed)
+		return method->method_ir;
+#endif
+
+	// callees compile while their caller holds the lock already, and
+	// another thread may have compiled the method while this one waited
+	context = acpi_context();
+	if(!context->compile_nesting)
+		ACPI_LOCK(&acpi_namespace_lock);
+
+	// methods the compiler can't handle keep running from AML
+	if(!method->method_ir && !method->method_ir_failed)
+	{
+		ir = acpi_compile_method(method);
+#ifdef ACPI_THREADS
+		if(!ir)
+			__atomic_store_n(&method->method_ir_failed, 1, __ATOMIC_RELAXED);
+		__atomic_store_n(&method->method_ir, ir, __ATOMIC_RELEASE);
+#else
+		if(!ir)
+			method->method_ir_failed = 1;
+		method->method_ir = ir;
+#endif
+	}
+
+	if(!context->compile_nesting)
+		ACPI_UNLOCK(&acpi_namespace_lock);
+
+	return method->method_ir;
+}
+
+// acpi_compile_emit(): Appends an instruction
+// Param:	acpi_compiler_t *compiler - compiler state
+// Param:	uint8_t opcode - IR opcode
+// Param:	int stack_change - how many objects the instruction pushes, negative for pops
+// Return:	acpi_irop_t * - the new instruction
+
+acpi_irop_t *acpi_compile_emit(acpi_compiler_t *compiler, uint8_t opcode, int stack_change)
+{
+	if(compiler->count >= compiler->allocation)
+	{
+		compiler->allocation += ACPI_IR_WINDOW;
+		compiler->code = acpi_realloc(compiler->code, compiler->allocation * sizeof(acpi_irop_t));
+	}
+
+	acpi_irop_t *op = &compiler->code[compiler->count];
+	acpi_memset(op, 0, sizeof(acpi_irop_t));
+	op->opcode = opcode;
+	compiler->count++;
+
+	compiler->stack_size += stack_change;
+	if(compiler->stack_size > compiler->max_stack_size)
+		compiler->max_stack_size = compiler->stack_size;
+
+	return op;
+}
+
+// acpi_compile_fold(): Folds constant expressions, and drops the code they make unreachable
+// Param:	acpi_compiler_t *compiler - compiler state, with the whole method compiled
+// Return:	Nothing
+
+void acpi_compile_fold(acpi_compiler_t *compiler)
+{
+	uint8_t *target;
+	size_t i;
+	int changed = 1;
+
+	// _OSI() chains are LOr()s of constants by now, so this repeats until
+	// nothing is left to fold
+	while(changed)
+	{
+		changed = 0;
+		target = acpi_calloc(1, compiler->count + 1);
+		for(i = 0; i < compiler->count; i++)
+		{
+			if(compiler->code[i].opcode == ACPI_IR_JUMP || compiler->code[i].opcode == ACPI_IR_JUMP_ZERO)
+				target[compiler->code[i].target] = 1;
+		}
+
+		for(i = 0; i < compiler->count; i++)
+		{
+			changed |= acpi_compile_fold_op(&compiler->code[i], compiler->count - i, &target[i]);
+
+			// what's left of an If() whose Else() was dropped
+			if(compiler->code[i].opcode == ACPI_IR_JUMP && compiler->code[i].target == i + 1)
+			{
+				compiler->code[i].opcode = ACPI_IR_NOP;
+				changed = 1;
+			}
+		}
+
+		acpi_free(target);
+
+		changed |= acpi_compile_prune(compiler);
+		if(changed)
+			acpi_compile_compact(compiler);
+	}
+}
+
+// acpi_compile_fold_op(): Folds a constant expression starting at an instruction
+// Param:	acpi_irop_t *code - instructions
+// Param:	size_t count - instructions left
+// Param:	uint8_t *target - for each instruction, whether something jumps to it
+// Return:	int - 1 if anything was folded
+
+int acpi_compile_fold_op(acpi_irop_t *code, size_t count, uint8_t *target)
+{
+	uint64_t a, b;
+
+	if(count < 2 || code[0].opcode != ACPI_IR_INTEGER)
+		return 0;
+
+	a = code[0].integer;
+
+	// If() and While() with a constant predicate
+	if(code[1].opcode == ACPI_IR_JUMP_ZERO && !target[1])
+	{
+		code[0].opcode = ACPI_IR_NOP;
+		if(a)
+			code[1].opcode = ACPI_IR_NOP;
+		else
+			code[1].opcode = ACPI_IR_JUMP;
+		return 1;
+	}
+
+	if((code[1].opcode == ACPI_IR_LNOT || code[1].opcode == ACPI_IR_NOT) && !target[1])
+	{
+		code[0].integer = (code[1].opcode == ACPI_IR_LNOT) ? (a == 0) : ~a;
+		code[1].opcode = ACPI_IR_NOP;
+		return 1;
+	}
+
+	if(count < 3 || code[1].opcode != ACPI_IR_INTEGER || target[1] || target[2])
+		return 0;
+
+	b = code[1].integer;
+
+	switch(code[2].opcode)
+	{
+	case ACPI_IR_ADD:
+		a += b;
+		break;
+	case ACPI_IR_SUBTRACT:
+		a -= b;
+		break;
+	case ACPI_IR_MULTIPLY:
+		a *= b;
+		break;
+	case ACPI_IR_AND:
+		a &= b;
+		break;
+	case ACPI_IR_OR:
+		a |= b;
+		break;
+	case ACPI_IR_XOR:
+		a ^= b;
+		break;
+	case ACPI_IR_LAND:
+		a = (a != 0 && b != 0) ? 1 : 0;
+		break;
+	case ACPI_IR_LOR:
+		a = (a != 0 || b != 0) ? 1 : 0;
+		break;
+	case ACPI_IR_LEQUAL:
+		a = (a == b) ? 1 : 0;
+		break;
+	case ACPI_IR_LGREATER:
+		a = (a > b) ? 1 : 0;
+		break;
+	case ACPI_IR_LLESS:
+		a = (a < b) ? 1 : 0;
+		break;
+	default:
+		return 0;
+	}
+
+	code[0].integer = a;
+	code[1].opcode = ACPI_IR_NOP;
+	code[2].opcode = ACPI_IR_NOP;
+	return 1;
+}
+
+// acpi_compile_prune(): Turns instructions that can never run into ACPI_IR_NOP
+// Param:	acpi_compiler_t *compiler - compiler state
+// Return:	int - 1 if anything was removed
+
+int acpi_compile_prune(acpi_compiler_t *compiler)
+{
+	acpi_irop_t *code = compiler->code;
+	uint8_t *reachable = acpi_calloc(1, compiler->count + 1);
+	size_t *pending = acpi_calloc(sizeof(size_t), compiler->count + 1);
+	size_t count = 0;
+	size_t i;
+	int changed = 0;
+
+	// follow every path from the start of the method
+	pending[count++] = 0;
+	while(count)
+	{
+		i = pending[--count];
+		while(i < compiler->count && !reachable[i])
+		{
+			reachable[i] = 1;
+
+			if(code[i].opcode == ACPI_IR_JUMP_ZERO && !reachable[code[i].target])
+				pending[count++] = code[i].target;
+
+			if(code[i].opcode == ACPI_IR_JUMP)
+				i = code[i].target;
+			else if(code[i].opcode == ACPI_IR_RETURN)
+				break;
+			else
+				i++;
+		}
+	}
+
+	for(i = 0; i < compiler->count; i++)
+	{
+		if(reachable[i] || code[i].opcode == ACPI_IR_NOP)
+			continue;
+
+		changed = 1;
+		if(code[i].name)
+			acpi_free(code[i].name);
+
+		code[i].name = NULL;
+		code[i].opcode = ACPI_IR_NOP;
+	}
+
+	acpi_free(reachable);
+	acpi_free(pending);
+	return changed;
+}
+
+// acpi_compile_compact(): Removes ACPI_IR_NOP instructions
+// Param:	acpi_compiler_t *compiler - compiler state
+// Return:	Nothing
+
+void acpi_compile_compact(acpi_compiler_t *compiler)
+{
+	acpi_irop_t *code = compiler->code;
+	size_t *map = acpi_calloc(sizeof(size_t), compiler->count + 1);
+	size_t i, count = 0;
+
+	// jumps to a removed instruction go to the one after it
+	for(i = 0; i < compiler->count; i++)
+	{
+		map[i] = count;
+		if(code[i].opcode != ACPI_IR_NOP)
+		{
+			code[count] = code[i];
+			count++;
+		}
+	}
+
+	map[compiler->count] = count;
+	compiler->count = count;
+
+	for(i = 0; i < count; i++)
+	{
+		if(code[i].opcode == ACPI_IR_JUMP || code[i].opcode == ACPI_IR_JUMP_ZERO)
+			code[i].target = map[code[i].target];
+	}
+
+	acpi_free(map);
+}
+
+// acpi_compile_fuse(): Replaces common instruction sequences with superinstructions
+// Param:	acpi_compiler_t *compiler - compiler state, with the whole method compiled
+// Return:	Nothing
+
+void acpi_compile_fuse(acpi_compiler_t *compiler)
+{
+	acpi_irop_t *code = compiler->code;
+	size_t *map = acpi_calloc(sizeof(size_t), compiler->count + 1);
+	uint8_t *target = acpi_calloc(1, compiler->count + 1);
+	acpi_irop_t fused;
+	size_t i, count = 0, length;
+
+	// a sequence can't be fused when something jumps into the middle of it
+	for(i = 0; i < compiler->count; i++)
+	{
+		if(code[i].opcode == ACPI_IR_JUMP || code[i].opcode == ACPI_IR_JUMP_ZERO)
+			target[code[i].target] = 1;
+	}
+
+	// this only ever shrinks the code, so it's done in place
+	i = 0;
+	while(i < compiler->count)
+	{
+		length = acpi_compile_match(&code[i], compiler->count - i, &target[i], &fused);
+		if(!length)
+		{
+			fused = code[i];
+			length = 1;
+		}
+
+		map[i] = count;
+		code[count] = fused;
+		count++;
+		i += length;
+	}
+
+	map[compiler->count] = count;
+	compiler->count = count;
+
+	for(i = 0; i < count; i++)
+	{
+		if(code[i].opcode == ACPI_IR_JUMP || code[i].opcode == ACPI_IR_JUMP_ZERO
+			|| (code[i].opcode >= ACPI_IR_JUMP_LOCAL_NE && code[i].opcode <= ACPI_IR_JUMP_LOCAL_LE))
+			code[i].target = map[code[i].target];
+	}
+
+	acpi_free(map);
+	acpi_free(target);
+}
+
+// acpi_compile_match(): Matches a superinstruction at the start of some code
+// Param:	acpi_irop_t *code - instructions
+// Param:	size_t count - instructions left
+// Param:	uint8_t *target - for each instruction, whether something jumps to it
+// Param:	acpi_irop_t *fused - destination to store the superinstruction
+// Return:	size_t - count of instructions it replaces, 0 if nothing matched
+
+size_t acpi_compile_match(acpi_irop_t *code, size_t count, uint8_t *target, acpi_irop_t *fused)
+{
+	// Increment(LocalX) and Decrement(LocalX)
+	if(count >= 4 && code[0].opcode == ACPI_IR_LOCAL
+		&& (code[1].opcode == ACPI_IR_INCREMENT || code[1].opcode == ACPI_IR_DECREMENT)
+		&& code[2].opcode == ACPI_IR_STORE_LOCAL && code[2].index == code[0].index
+		&& code[3].opcode == ACPI_IR_POP
+		&& !target[1] && !target[2] && !target[3])
+	{
+		fused[0] = code[0];
+		fused->opcode = (code[1].opcode == ACPI_IR_INCREMENT) ? ACPI_IR_INCREMENT_LOCAL : ACPI_IR_DECREMENT_LOCAL;
+		return 4;
+	}
+
+	// If(LEqual(LocalX, integer)), and the same with LLess() and LGreater()
+	if(count >= 4 && code[0].opcode == ACPI_IR_LOCAL && code[1].opcode == ACPI_IR_INTEGER
+		&& (code[2].opcode == ACPI_IR_LEQUAL || code[2].opcode == ACPI_IR_LLESS || code[2].opcode == ACPI_IR_LGREATER)
+		&& code[3].opcode == ACPI_IR_JUMP_ZERO
+		&& !target[1] && !target[2] && !target[3])
+	{
+		fused[0] = code[3];
+		fused->index = code[0].index;
+		fused->integer = code[1].integer;
+
+		if(code[2].opcode == ACPI_IR_LEQUAL)
+			fused->opcode = ACPI_IR_JUMP_LOCAL_NE;
+		else if(code[2].opcode == ACPI_IR_LLESS)
+			fused->opcode = ACPI_IR_JUMP_LOCAL_GE;
+		else
+			fused->opcode = ACPI_IR_JUMP_LOCAL_LE;
+		return 4;
+	}
+
+	// And(ShiftRight(x, integer), integer), for reading bits out of a register
+	if(count >= 4 && code[0].opcode == ACPI_IR_INTEGER && code[0].integer < 64
+		&& code[1].opcode == ACPI_IR_SHR && code[2].opcode == ACPI_IR_INTEGER
+		&& code[3].opcode == ACPI_IR_AND
+		&& !target[1] && !target[2] && !target[3])
+	{
+		fused[0] = code[2];
+		fused->opcode = ACPI_IR_SHR_AND;
+		fused->index = (uint8_t)code[0].integer;
+		return 4;
+	}
+
+	// Store(Name, LocalX), usually reading a Field
+	if(count >= 3 && code[0].opcode == ACPI_IR_NAME
+		&& code[1].opcode == ACPI_IR_STORE_LOCAL && code[2].opcode == ACPI_IR_POP
+		&& !target[1] && !target[2])
+	{
+		fused[0] = code[0];
+		fused->opcode = ACPI_IR_NAME_TO_LOCAL;
+		fused->index = code[1].index;
+		return 3;
+	}
+
+	// any other statement that ends by storing to LocalX
+	if(count >= 2 && code[0].opcode == ACPI_IR_STORE_LOCAL && code[1].opcode == ACPI_IR_POP
+		&& !target[1])
+	{
+		fused[0] = code[0];
+		fused->opcode = ACPI_IR_SET_LOCAL;
+		return 2;
+	}
+
+	return 0;
+}
+
+// acpi_compile_slots(): Works out which LocalX and ArgX a method uses
+// Param:	acpi_compiler_t *compiler - compiler state, with the whole method compiled
+// Param:	acpi_ir_t *ir - compiled method, with argc set
+// Return:	Nothing
+
+void acpi_compile_slots(acpi_compiler_t *compiler, acpi_ir_t *ir)
+{
+	acpi_irop_t *code = compiler->code;
+	size_t i;
+
+	// the caller fills in the arguments the method takes
+	ir->local_count = 0;
+	ir->arg_count = ir->argc;
+
+	for(i = 0; i < compiler->count; i++)
+	{
+		switch(code[i].opcode)
+		{
+		case ACPI_IR_LOCAL:
+		case ACPI_IR_STORE_LOCAL:
+		case ACPI_IR_SET_LOCAL:
+		case ACPI_IR_NAME_TO_LOCAL:
+		case ACPI_IR_INCREMENT_LOCAL:
+		case ACPI_IR_DECREMENT_LOCAL:
+		case ACPI_IR_JUMP_LOCAL_NE:
+		case ACPI_IR_JUMP_LOCAL_GE:
+		case ACPI_IR_JUMP_LOCAL_LE:
+			if(code[i].index >= ir->local_count)
+				ir->local_count = code[i].index + 1;
+			break;
+
+		case ACPI_IR_ARG:
+		case ACPI_IR_STORE_ARG:
+			if(code[i].index >= ir->arg_count)
+				ir->arg_count = code[i].index + 1;
+			break;
+
+		case ACPI_IR_STORE_INDEX:
+			if(code[i].integer == ACPI_IR_LOCAL && code[i].index >= ir->local_count)
+				ir->local_count = code[i].index + 1;
+			else if(code[i].integer == ACPI_IR_ARG && code[i].index >= ir->arg_count)
+				ir->arg_count = code[i].index + 1;
+			break;
+
+		case ACPI_IR_AML:
+		case ACPI_IR_EXEC:
+			// operands evaluated from AML may store anywhere
+			ir->local_count = 8;
+			ir->arg_count = 7;
+			return;
+		}
+	}
+}
+
+// acpi_compile_pure(): Decides whether a method's result only depends on its arguments
+// Param:	acpi_compiler_t *compiler - compiler state, with the whole method compiled
+// Return:	int - 1 if the method reads and writes nothing but its locals and arguments
+
+int acpi_compile_pure(acpi_compiler_t *compiler)
+{
+	acpi_irop_t *code = compiler->code;
+	uint64_t integer;
+	size_t pkgsize, block_size, i;
+
+	for(i = 0; i < compiler->count; i++)
+	{
+		switch(code[i].opcode)
+		{
+		// anything in the namespace, including Fields, can change between calls
+		case ACPI_IR_NAME:
+		case ACPI_IR_NAME_TO_LOCAL:
+		case ACPI_IR_STORE_NAME:
+		case ACPI_IR_DEFINE_NAME:
+		case ACPI_IR_CONDREF:
+		case ACPI_IR_EXEC:
+		case ACPI_IR_SLEEP:
+		case ACPI_IR_STALL:
+		case ACPI_IR_TIMER:
+		case ACPI_IR_ACQUIRE:
+		case ACPI_IR_RELEASE:
+		case ACPI_IR_WAIT:
+		case ACPI_IR_SIGNAL:
+		case ACPI_IR_RESET:
+		case ACPI_IR_INVOKE:
+		// the arguments are what the result is cached by
+		case ACPI_IR_STORE_ARG:
+			return 0;
+
+		case ACPI_IR_STORE_INDEX:
+			if(code[i].integer != ACPI_IR_LOCAL)
+				return 0;
+			break;
+
+		case ACPI_IR_AML:
+			// Package() is constant data, Buffer() is too when its size is
+			if(code[i].aml[0] == BUFFER_OP)
+			{
+				pkgsize = acpi_parse_pkgsize(&code[i].aml[1], &block_size);
+				if(!acpi_eval_integer(&code[i].aml[1 + pkgsize], &integer))
+					return 0;
+			} else if(code[i].aml[0] != PACKAGE_OP)
+				return 0;
+			break;
+		}
+	}
+
+	return 1;
+}
+
+// acpi_compile_path(): Copies a path into its own allocation
+// Param:	char *path - path
+// Return:	char * - copy of path
+
+char *acpi_compile_path(char *path)
+{
+	char *copy = acpi_malloc(acpi_strlen(path) + 1);
+	acpi_strcpy(copy, path);
+	return copy;
+}
+
+// acpi_compile_block(): Compiles a list of statements
+// Param:	acpi_compiler_t *compiler - compiler state
+// Param:	uint8_t *data - AML
+// Param:	size_t size - size of AML in bytes
+// Return:	size_t - size compiled, less than size on error
+
+size_t acpi_compile_block(acpi_compiler_t *compiler, uint8_t *data, size_t size)
+{
+	size_t count = 0;
+	size_t statement_size;
+
+	while(count < size)
+	{
+		statement_size = acpi_compile_statement(compiler, &data[count], size - count);
+		if(!statement_size)
+			return count;
+
+		count += statement_size;
+	}
+
+	return count;
+}
+
+// acpi_compile_statement(): Compiles a Type1Opcode, or a Type2Opcode whose result is unused
+// Param:	acpi_compiler_t *compiler - compiler state
+// Param:	uint8_t *data - AML
+// Param:	size_t limit - bytes left in the enclosing block
+// Return:	size_t - size in bytes for skipping, 0 on error
+
+size_t acpi_compile_statement(acpi_compiler_t *compiler, uint8_t *data, size_t limit)
+{
+	size_t return_size = 0;
+	size_t size, pkgsize, block_size;
+	acpi_irop_t *op;
+	size_t jump, skip, loop_start, i;
+	uint64_t integer;
+	char path[ACPI_MAX_NAME];
+	int in_loop;
+
+	switch(data[0])
+	{
+	case NOP_OP:
+		return 1;
+
+	/* If/Else Conditional */
+	case IF_OP:
+		pkgsize = acpi_parse_pkgsize(&data[1], &block_size);
+		return_size = block_size + 1;
+
+		size = acpi_compile_term(compiler, &data[1 + pkgsize]);
+		if(!size)
+			return 0;
+
+		jump = compiler->count;
+		acpi_compile_emit(compiler, ACPI_IR_JUMP_ZERO, -1);
+
+		skip = 1 + pkgsize + size;
+		if(acpi_compile_block(compiler, &data[skip], return_size - skip) != return_size - skip)
+			return 0;
+
+		// is there an Else?
+		if(return_size < limit && data[return_size] == ELSE_OP)
+		{
+			skip = compiler->count;
+			acpi_compile_emit(compiler, ACPI_IR_JUMP, 0);
+			compiler->code[jump].target = compiler->count;
+			jump = skip;
+
+			pkgsize = acpi_parse_pkgsize(&data[return_size + 1], &block_size);
+			if(acpi_compile_block(compiler, &data[return_size + 1 + pkgsize], block_size - pkgsize) != block_size - pkgsize)
+				return 0;
+
+			return_size += block_size + 1;
+		}
+
+		compiler->code[jump].target = compiler->count;
+		return return_size;
+
+	/* While Loops */
+	case WHILE_OP:
+		pkgsize = acpi_parse_pkgsize(&data[1], &block_size);
+		return_size = block_size + 1;
+
+		in_loop = compiler->in_loop;
+		loop_start = compiler->loop_start;
+		compiler->in_loop = 1;
+		compiler->loop_start = compiler->count;
+
+		size = acpi_compile_term(compiler, &data[1 + pkgsize]);
+		if(!size)
+			return 0;
+
+		jump = compiler->count;
+		acpi_compile_emit(compiler, ACPI_IR_JUMP_ZERO, -1);
+
+		skip = 1 + pkgsize + size;
+		if(acpi_compile_block(compiler, &data[skip], return_size - skip) != return_size - skip)
+			return 0;
+
+		op = acpi_compile_emit(compiler, ACPI_IR_JUMP, 0);
+		op->target = compiler->loop_start;
+		compiler->code[jump].target = compiler->count;
+
+		// Break jumps to the end of the innermost loop
+		// inner loops have already resolved theirs, so all that are left are ours
+		for(i = jump; i < compiler->count; i++)
+		{
+			if(compiler->code[i].opcode == ACPI_IR_BREAK)
+			{
+				compiler->code[i].opcode = ACPI_IR_JUMP;
+				compiler->code[i].target = compiler->count;
+			}
+		}
+
+		compiler->in_loop = in_loop;
+		compiler->loop_start = loop_start;
+		return return_size;
+
+	case BREAK_OP:
+		if(!compiler->in_loop)
+			return 0;
+
+		acpi_compile_emit(compiler, ACPI_IR_BREAK, 0);
+		return 1;
+
+	case CONTINUE_OP:
+		if(!compiler->in_loop)
+			return 0;
+
+		op = acpi_compile_emit(compiler, ACPI_IR_JUMP, 0);
+		op->target = compiler->loop_start;
+		return 1;
+
+	/* A control method can return literally any object */
+	case RETURN_OP:
+		size = acpi_compile_term(compiler, &data[1]);
+		if(!size)
+			return 0;
+
+		acpi_compile_emit(compiler, ACPI_IR_RETURN, -1);
+		return size + 1;
+
+	/* Names within methods */
+	case NAME_OP:
+		return_size = acpins_resolve_path(path, &data[1]) + 1;
+
+		size = acpi_compile_term(compiler, &data[return_size]);
+		if(!size)
+			return 0;
+
+		op = acpi_compile_emit(compiler, ACPI_IR_DEFINE_NAME, -1);
+		op->name = acpi_compile_path(path);
+		return return_size + size;
+
+	case BYTEFIELD_OP:
+	case WORDFIELD_OP:
+	case DWORDFIELD_OP:
+	case QWORDFIELD_OP:
+		// the namespace code only handles a named buffer and a constant index
+		if(!acpi_is_name(data[1]))
+			return 0;
+
+		return_size = acpins_resolve_path(path, &data[1]) + 1;
+		size = acpi_eval_integer(&data[return_size], &integer);
+		if(!size)
+			return 0;
+
+		return_size += size;
+		return_size += acpins_resolve_path(path, &data[return_size]);
+
+		op = acpi_compile_emit(compiler, ACPI_IR_EXEC, 0);
+		op->index = data[0];
+		op->aml = data;
+		return return_size;
+
+	case EXTOP_PREFIX:
+		if(data[1] == SLEEP_OP)
+		{
+			size = acpi_compile_term(compiler, &data[2]);
+			if(!size)
+				return 0;
+
+			acpi_compile_emit(compiler, ACPI_IR_SLEEP, -1);
+			return size + 2;
+		}
+
+		if(data[1] == STALL_OP)
+		{
+			size = acpi_compile_term(compiler, &data[2]);
+			if(!size)
+				return 0;
+
+			acpi_compile_emit(compiler, ACPI_IR_STALL, -1);
+			return size + 2;
+		}
+
+		if(data[1] == RELEASE_OP && acpi_is_name(data[2]))
+		{
+			size = acpins_resolve_path(path, &data[2]);
+			op = acpi_compile_emit(compiler, ACPI_IR_RELEASE, 0);
+			op->name = acpi_compile_path(path);
+			return size + 2;
+		}
+
+		if((data[1] == SIGNAL_OP || data[1] == RESET_OP) && acpi_is_name(data[2]))
+		{
+			size = acpins_resolve_path(path, &data[2]);
+			op = acpi_compile_emit(compiler, (data[1] == SIGNAL_OP) ? ACPI_IR_SIGNAL : ACPI_IR_RESET, 0);
+			op->name = acpi_compile_path(path);
+			return size + 2;
+		}
+
+		break;
+	}
+
+	// everything else is an expression whose value is discarded
+	// this includes MethodInvokations and Store()
+	size = acpi_compile_term(compiler, data);
+	if(!size)
+		return 0;
+
+	acpi_compile_emit(compiler, ACPI_IR_POP, -1);
+	return size;
+}
+
+// acpi_compile_operands(): Compiles a fixed number of operands
+// Param:	acpi_compiler_t *compiler - compiler state
+// Param:	uint8_t *data - AML of first operand
+// Param:	size_t count - operand count
+// Return:	size_t - size in bytes for skipping, 0 on error
+
+size_t acpi_compile_operands(acpi_compiler_t *compiler, uint8_t *data, size_t count)
+{
+	size_t return_size = 0;
+	size_t size;
+
+	while(count)
+	{
+		size = acpi_compile_term(compiler, &data[return_size]);
+		if(!size)
+			return 0;
+
+		return_size += size;
+		count--;
+	}
+
+	return return_size;
+}
+
+// acpi_compile_name(): Compiles a NameString used as an operand
+// Param:	acpi_compiler_t *compiler - compiler state
+// Param:	uint8_t *data - AML
+// Return:	size_t - size in bytes for skipping, 0 on error
+
+size_t acpi_compile_name(acpi_compiler_t *compiler, uint8_t *data)
+{
+	char path[ACPI_MAX_NAME];
+	char resolved[ACPI_MAX_NAME];
+	size_t return_size, size;
+	acpi_irop_t *op;
+	acpi_handle_t *handle;
+
+	return_size = acpins_resolve_path(path, data);
+
+	// whether this is a MethodInvokation decides how many bytes follow
+	// so methods are resolved now; they don't come and go at run time
+	acpi_strcpy(resolved, path);
+	handle = acpi_exec_resolve(resolved);
+
+	if(handle && handle->type == ACPI_NAMESPACE_METHOD)
+	{
+		uint8_t argc = handle->method_flags & METHOD_ARGC_MASK;
+
+		size = acpi_compile_operands(compiler, &data[return_size], argc);
+		if(argc && !size)
+			return 0;
+
+		// the OS-defined methods always return the same thing for the same
+		// arguments, so they become constants, see acpi_compile_fold()
+		if(!acpi_strcmp(handle->path, "\\._OSI") && compiler->code[compiler->count - 1].opcode == ACPI_IR_STRING)
+		{
+			op = &compiler->code[compiler->count - 1];
+			op->opcode = ACPI_IR_INTEGER;
+			op->integer = acpi_exec_osi((char*)op->aml);
+			return return_size + size;
+		} else if(!acpi_strcmp(handle->path, "\\._OS_"))
+		{
+			op = acpi_compile_emit(compiler, ACPI_IR_STRING, 1);
+			op->aml = (uint8_t*)acpi_emulated_os;
+			return return_size;
+		} else if(!acpi_strcmp(handle->path, "\\._REV"))
+		{
+			op = acpi_compile_emit(compiler, ACPI_IR_INTEGER, 1);
+			op->integer = acpi_implemented_version;
+			return return_size;
+		}
+
+		if(acpi_compile_inline(compiler, handle))
+			return return_size + size;
+
+		op = acpi_compile_emit(compiler, ACPI_IR_INVOKE, 1 - (int)argc);
+		op->index = argc;
+		op->name = acpi_compile_path(handle->path);
+		return return_size + size;
+	}
+
+	// anything else may be created by the method itself, so it's resolved at run time
+	op = acpi_compile_emit(compiler, ACPI_IR_NAME, 1);
+	op->name = acpi_compile_path(path);
+	return return_size;
+}
+
+// acpi_compile_inline(): Copies the IR of a small method in place of a call to it
+// Param:	acpi_compiler_t *compiler - compiler state, with the arguments already on the stack
+// Param:	acpi_handle_t *method - method being called
+// Return:	int - 1 if it was inlined, 0 if it takes a MethodInvokation
+
+int acpi_compile_inline(acpi_compiler_t *compiler, acpi_handle_t *method)
+{
+	acpi_context_t *context = acpi_context();
+	uint8_t argc = method->method_flags & METHOD_ARGC_MASK;
+	size_t index = method->index;
+	size_t base, depth, start, body, i;
+	acpi_irop_t *op;
+	acpi_ir_t *ir;
+
+	// OS-defined methods have no AML, and recursion always stays a call, as
+	// do Serialized methods, which need a frame to hold their mutex
+	if(!method->pointer || method->mutex || context->compile_nesting >= ACPI_INLINE_DEPTH)
+		return 0;
+
+	for(i = 0; i < context->compile_nesting; i++)
+	{
+		if(context->compile_methods[i] == index)
+			return 0;
+	}
+
+	ir = acpi_compile_cached(method);
+	if(!ir || ir->count > ACPI_INLINE_SIZE || compiler->stack_size + ir->stack_size > ACPI_IR_MAX_STACK)
+		return 0;
+
+	// a Return at the very end becomes a fall-through, anywhere else it
+	// would need a jump out of the callee
+	body = ir->count;
+	if(body && ir->code[body - 1].opcode == ACPI_IR_RETURN)
+		body--;
+
+	for(i = 0; i < ir->count; i++)
+	{
+		op = &ir->code[i];
+		switch(op->opcode)
+		{
+		// the callee's Locals would be the caller's, and its Args are
+		// read-only copies on the operand stack
+		case ACPI_IR_LOCAL:
+		case ACPI_IR_STORE_LOCAL:
+		case ACPI_IR_STORE_ARG:
+		case ACPI_IR_SET_LOCAL:
+		case ACPI_IR_NAME_TO_LOCAL:
+		case ACPI_IR_INCREMENT_LOCAL:
+		case ACPI_IR_DECREMENT_LOCAL:
+		case ACPI_IR_JUMP_LOCAL_NE:
+		case ACPI_IR_JUMP_LOCAL_GE:
+		case ACPI_IR_JUMP_LOCAL_LE:
+		// AML is evaluated in the scope of the running method, and Name()s
+		// go away when the method that created them returns
+		case ACPI_IR_AML:
+		case ACPI_IR_EXEC:
+		case ACPI_IR_DEFINE_NAME:
+			return 0;
+
+		case ACPI_IR_STORE_INDEX:
+			if(op->integer == ACPI_IR_LOCAL || op->integer == ACPI_IR_ARG)
+				return 0;
+			break;
+
+		case ACPI_IR_RETURN:
+			if(i != body)
+				return 0;
+			break;
+
+		case ACPI_IR_JUMP:
+		case ACPI_IR_JUMP_ZERO:
+			// falling off the end returns 0, which the Return at the end doesn't
+			if(body != ir->count && op->target > body)
+				return 0;
+			break;
+		}
+	}
+
+	// names in the IR are full paths already, so they mean the same here
+	base = compiler->stack_size - argc;
+	depth = compiler->stack_size;
+	start = compiler->count;
+
+	for(i = 0; i < body; i++)
+	{
+		op = acpi_compile_emit(compiler, ACPI_IR_NOP, 0);
+		op[0] = ir->code[i];
+		op->generation = 0;
+		if(op->name)
+			op->name = acpi_compile_path(op->name);
+
+		if(op->opcode == ACPI_IR_ARG)
+		{
+			op->opcode = ACPI_IR_STACK;
+			op->index = base + op->index;
+		} else if(op->opcode == ACPI_IR_STACK)
+			op->index += depth;
+		else if(op->opcode == ACPI_IR_JUMP || op->opcode == ACPI_IR_JUMP_ZERO)
+			op->target += start;
+	}
+
+	if(depth + ir->stack_size > compiler->max_stack_size)
+		compiler->max_stack_size = depth + ir->stack_size;
+
+	// the result ends up on top of the arguments
+	if(body == ir->count)
+	{
+		op = acpi_compile_emit(compiler, ACPI_IR_INTEGER, 1);
+		op->integer = 0;
+	} else
+		compiler->stack_size++;
+
+	if(argc)
+	{
+		op = acpi_compile_emit(compiler, ACPI_IR_SLIDE, -(int)argc);
+		op->index = argc;
+	}
+
+	return 1;
+}
+
+// acpi_compile_target(): Compiles the destination of a Store() or an arithmetic opcode
+// Param:	acpi_compiler_t *compiler - compiler state
+// Param:	uint8_t *data - AML
+// Return:	size_t - size in bytes for skipping, 0 on error
+
+size_t acpi_compile_target(acpi_compiler_t *compiler, uint8_t *data)
+{
+	char path[ACPI_MAX_NAME];
+	char resolved[ACPI_MAX_NAME];
+	size_t return_size, size, index;
+	acpi_irop_t *op;
+	acpi_handle_t *handle;
+	int holder;
+
+	if(data[0] == ZERO_OP)		// NullName, the result is not stored
+		return 1;
+
+	if(data[0] >= LOCAL0_OP && data[0] <= LOCAL7_OP)
+	{
+		op = acpi_compile_emit(compiler, ACPI_IR_STORE_LOCAL, 0);
+		op->index = data[0] - LOCAL0_OP;
+		return 1;
+	} else if(data[0] >= ARG0_OP && data[0] <= ARG6_OP)
+	{
+		op = acpi_compile_emit(compiler, ACPI_IR_STORE_ARG, 0);
+		op->index = data[0] - ARG0_OP;
+		return 1;
+	} else if(acpi_is_name(data[0]))
+	{
+		return_size = acpins_resolve_path(path, data);
+		op = acpi_compile_emit(compiler, ACPI_IR_STORE_NAME, 0);
+		op->name = acpi_compile_path(path);
+		return return_size;
+	} else if(data[0] == INDEX_OP)
+	{
+		// the write goes to the object holding the package or buffer
+		// so only a LocalX, an ArgX or a Name() can be the source here
+		if(data[1] >= LOCAL0_OP && data[1] <= LOCAL7_OP)
+		{
+			holder = ACPI_IR_LOCAL;
+			index = data[1] - LOCAL0_OP;
+			return_size = 2;
+		} else if(data[1] >= ARG0_OP && data[1] <= ARG6_OP)
+		{
+			holder = ACPI_IR_ARG;
+			index = data[1] - ARG0_OP;
+			return_size = 2;
+		} else if(acpi_is_name(data[1]))
+		{
+			holder = ACPI_IR_NAME;
+			index = 0;
+			return_size = acpins_resolve_path(path, &data[1]) + 1;
+
+			acpi_strcpy(resolved, path);
+			handle = acpi_exec_resolve(resolved);
+			if(handle && handle->type == ACPI_NAMESPACE_METHOD)
+				return 0;
+		} else
+			return 0;
+
+		size = acpi_compile_term(compiler, &data[return_size]);
+		if(!size)
+			return 0;
+
+		return_size += size;
+
+		// Index() can store the reference itself too, which we don't support
+		if(data[return_size] != ZERO_OP)
+			return 0;
+
+		op = acpi_compile_emit(compiler, ACPI_IR_STORE_INDEX, -1);
+		op->integer = holder;
+		op->index = index;
+		if(holder == ACPI_IR_NAME)
+			op->name = acpi_compile_path(path);
+
+		return return_size + 1;
+	}
+
+	return 0;
+}
+
+// acpi_compile_term(): Compiles an operand, leaving its value on the stack
+// Param:	acpi_compiler_t *compiler - compiler state
+// Param:	uint8_t *data - AML
+// Return:	size_t - size in bytes for skipping, 0 on error
+
+size_t acpi_compile_term(acpi_compiler_t *compiler, uint8_t *data)
+{
+	size_t return_size, size, pkgsize;
+	uint64_t integer;
+	acpi_irop_t *op;
+	uint8_t opcode;
+	char path[ACPI_MAX_NAME];
+
+	// try register
+	if(data[0] >= LOCAL0_OP && data[0] <= LOCAL7_OP)
+	{
+		op = acpi_compile_emit(compiler, ACPI_IR_LOCAL, 1);
+		op->index = data[0] - LOCAL0_OP;
+		return 1;
+	} else if(data[0] >= ARG0_OP && data[0] <= ARG6_OP)
+	{
+		op = acpi_compile_emit(compiler, ACPI_IR_ARG, 1);
+		op->index = data[0] - ARG0_OP;
+		return 1;
+	}
+
+	// try integer
+	size = acpi_eval_integer(data, &integer);
+	if(size != 0)
+	{
+		op = acpi_compile_emit(compiler, ACPI_IR_INTEGER, 1);
+		op->integer = integer;
+		return size;
+	}
+
+	if(acpi_is_name(data[0]))
+		return acpi_compile_name(compiler, data);
+
+	switch(data[0])
+	{
+	case STRINGPREFIX:
+		op = acpi_compile_emit(compiler, ACPI_IR_STRING, 1);
+		op->aml = &data[1];
+		return acpi_strlen((char*)&data[1]) + 2;
+
+	case PACKAGE_OP:
+	case VARPACKAGE_OP:
+	case BUFFER_OP:
+		// these are still built by acpi_eval_object() every time
+		acpi_parse_pkgsize(&data[1], &pkgsize);
+		op = acpi_compile_emit(compiler, ACPI_IR_AML, 1);
+		op->aml = data;
+		return pkgsize + 1;
+
+	case DEREF_OP:
+		size = acpi_compile_term(compiler, &data[1]);
+		if(!size)
+			return 0;
+		return size + 1;
+
+	case SIZEOF_OP:
+		size = acpi_compile_term(compiler, &data[1]);
+		if(!size)
+			return 0;
+
+		acpi_compile_emit(compiler, ACPI_IR_SIZEOF, 0);
+		return size + 1;
+
+	case INDEX_OP:
+		size = acpi_compile_operands(compiler, &data[1], 2);
+		if(!size)
+			return 0;
+
+		acpi_compile_emit(compiler, ACPI_IR_INDEX, -1);
+		return_size = size + 1;
+
+		// the target of Index() would receive a reference
+		if(data[return_size] != ZERO_OP)
+			return 0;
+
+		return return_size + 1;
+
+	case LNOT_OP:
+		size = acpi_compile_term(compiler, &data[1]);
+		if(!size)
+			return 0;
+
+		acpi_compile_emit(compiler, ACPI_IR_LNOT, 0);
+		return size + 1;
+
+	case LAND_OP:
+	case LOR_OP:
+	case LEQUAL_OP:
+	case LGREATER_OP:
+	case LLESS_OP:
+		size = acpi_compile_operands(compiler, &data[1], 2);
+		if(!size)
+			return 0;
+
+		if(data[0] == LAND_OP)
+			opcode = ACPI_IR_LAND;
+		else if(data[0] == LOR_OP)
+			opcode = ACPI_IR_LOR;
+		else if(data[0] == LEQUAL_OP)
+			opcode = ACPI_IR_LEQUAL;
+		else if(data[0] == LGREATER_OP)
+			opcode = ACPI_IR_LGREATER;
+		else
+			opcode = ACPI_IR_LLESS;
+
+		acpi_compile_emit(compiler, opcode, -1);
+		return size + 1;
+
+	case ADD_OP:
+	case SUBTRACT_OP:
+	case MULTIPLY_OP:
+	case AND_OP:
+	case OR_OP:
+	case XOR_OP:
+	case SHL_OP:
+	case SHR_OP:
+		size = acpi_compile_operands(compiler, &data[1], 2);
+		if(!size)
+			return 0;
+
+		switch(data[0])
+		{
+		case ADD_OP:
+			opcode = ACPI_IR_ADD;
+			break;
+		case SUBTRACT_OP:
+			opcode = ACPI_IR_SUBTRACT;
+			break;
+		case MULTIPLY_OP:
+			opcode = ACPI_IR_MULTIPLY;
+			break;
+		case AND_OP:
+			opcode = ACPI_IR_AND;
+			break;
+		case OR_OP:
+			opcode = ACPI_IR_OR;
+			break;
+		case XOR_OP:
+			opcode = ACPI_IR_XOR;
+			break;
+		case SHL_OP:
+			opcode = ACPI_IR_SHL;
+			break;
+		default:
+			opcode = ACPI_IR_SHR;
+			break;
+		}
+
+		acpi_compile_emit(compiler, opcode, -1);
+		return_size = size + 1;
+
+		size = acpi_compile_target(compiler, &data[return_size]);
+		if(!size)
+			return 0;
+
+		return return_size + size;
+
+	case NOT_OP:
+		size = acpi_compile_term(compiler, &data[1]);
+		if(!size)
+			return 0;
+
+		acpi_compile_emit(compiler, ACPI_IR_NOT, 0);
+		return_size = size + 1;
+
+		size = acpi_compile_target(compiler, &data[return_size]);
+		if(!size)
+			return 0;
+
+		return return_size + size;
+
+	case DIVIDE_OP:
+		size = acpi_compile_operands(compiler, &data[1], 2);
+		if(!size)
+			return 0;
+
+		acpi_compile_emit(compiler, ACPI_IR_DIVIDE, 0);
+		return_size = size + 1;
+
+		// remainder is on top of the quotient
+		size = acpi_compile_target(compiler, &data[return_size]);
+		if(!size)
+			return 0;
+
+		return_size += size;
+		acpi_compile_emit(compiler, ACPI_IR_POP, -1);
+
+		size = acpi_compile_target(compiler, &data[return_size]);
+		if(!size)
+			return 0;
+
+		return return_size + size;
+
+	case INCREMENT_OP:
+	case DECREMENT_OP:
+		size = acpi_compile_term(compiler, &data[1]);
+		if(!size)
+			return 0;
+
+		if(data[0] == INCREMENT_OP)
+			acpi_compile_emit(compiler, ACPI_IR_INCREMENT, 0);
+		else
+			acpi_compile_emit(compiler, ACPI_IR_DECREMENT, 0);
+
+		// and write it back to the same SuperName
+		if(acpi_compile_target(compiler, &data[1]) != size)
+			return 0;
+
+		return size + 1;
+
+	case STORE_OP:
+		return_size = acpi_compile_term(compiler, &data[1]);
+		if(!return_size)
+			return 0;
+
+		return_size++;
+
+		size = acpi_compile_target(compiler, &data[return_size]);
+		if(!size)
+			return 0;
+
+		return return_size + size;
+
+	case EXTOP_PREFIX:
+		if(data[1] == CONDREF_OP)
+		{
+			return_size = acpins_resolve_path(path, &data[2]) + 2;
+
+			// the target of CondRefOf() would receive a reference
+			if(data[return_size] != ZERO_OP)
+				return 0;
+
+			op = acpi_compile_emit(compiler, ACPI_IR_CONDREF, 1);
+			op->name = acpi_compile_path(path);
+			return return_size + 1;
+		}
+
+		if(data[1] == TIMER_OP)
+		{
+			acpi_compile_emit(compiler, ACPI_IR_TIMER, 1);
+			return 2;
+		}
+
+		// the mutex can only be named, not a reference
+		if(data[1] == ACQUIRE_OP && acpi_is_name(data[2]))
+		{
+			return_size = acpins_resolve_path(path, &data[2]) + 2;
+			op = acpi_compile_emit(compiler, ACPI_IR_ACQUIRE, 1);
+			op->name = acpi_compile_path(path);
+			op->integer = data[return_size] | (data[return_size + 1] << 8);
+			return return_size + 2;
+		}
+
+		// unlike Acquire(), the timeout is a TermArg
+		if(data[1] == WAIT_OP && acpi_is_name(data[2]))
+		{
+			return_size = acpins_resolve_path(path, &data[2]) + 2;
+			size = acpi_compile_term(compiler, &data[return_size]);
+			if(!size)
+				return 0;
+
+			op = acpi_compile_emit(compiler, ACPI_IR_WAIT, 0);
+			op->name = acpi_compile_path(path);
+			return return_size + size;
+		}
+
+		return 0;
+
+	default:
+		return 0;
+	}
+}
@@ -114,535 +114,585 @@ int acpi_eval_package(acpi_object_t *package, size_t index, acpi_object_t *desti
 
 size_t acpi_eval_object(acpi_object_t *destination, acpi_state_t *state, void *data)
 {
-	size_t return_size = 0;
 	uint8_t *object = (uint8_t*)data;
+	acpi_eval_handler_t handler;
 
-	size_t integer_size;
-	uint64_t integer;
-	size_t name_size;
-	acpi_handle_t *handle;
-	char name[ACPI_MAX_NAME];
-	acpi_object_t *destination_reg;
-	acpi_object_t *sizeof_object;
-	acpi_object_t n1, n2;
+	if(object[0] == EXTOP_PREFIX)
+		handler = acpi_extopcodes[object[1]].eval;
+	else
+		handler = acpi_opcodes[object[0]].eval;
 
-	// try register
-	if(object[0] >= LOCAL0_OP && object[0] <= LOCAL7_OP)
+	if(!handler)
 	{
-		switch(object[0])
-		{
-		case LOCAL0_OP:
-			destination_reg = &state->local[0];
-			break;
-		case LOCAL1_OP:
-			destination_reg = &state->local[1];
-			break;
-		case LOCAL2_OP:
-			destination_reg = &state->local[2];
-			break;
-		case LOCAL3_OP:
-			destination_reg = &state->local[3];
-			break;
-		case LOCAL4_OP:
-			destination_reg = &state->local[4];
-			break;
-		case LOCAL5_OP:
-			destination_reg = &state->local[5];
-			break;
-		case LOCAL6_OP:
-			destination_reg = &state->local[6];
-			break;
-		case LOCAL7_OP:
-			destination_reg = &state->local[7];
-			break;
-		}
-
-		acpi_copy_object(destination, destination_reg);
+		acpi_panic("acpi: undefined opcode, sequence: %xb %xb %xb %xb\n", object[0], object[1], object[2], object[3]);
+	}
+
+	return handler(destination, state, data);
+}
+
+// acpi_eval_operands(): Evaluates the two operands of a Type2Opcode
+// Param:	acpi_state_t *state - AML VM state
+// Param:	uint8_t *object - first operand
+// Param:	acpi_object_t *n1 - destination of first operand
+// Param:	acpi_object_t *n2 - destination of second operand
+// Return:	size_t - size in bytes for skipping
+
+size_t acpi_eval_operands(acpi_state_t *state, uint8_t *object, acpi_object_t *n1, acpi_object_t *n2)
+{
+	size_t return_size;
+
+	return_size = acpi_eval_object(n1, state, &object[0]);
+	return_size += acpi_eval_object(n2, state, &object[return_size]);
+	return return_size;
+}
+
+// acpi_eval_result(): Stores the result of a Type2Opcode in its target
+// Param:	acpi_object_t *destination - where to store result
+// Param:	acpi_state_t *state - AML VM state
+// Param:	uint8_t *target - target of the opcode
+// Param:	uint64_t integer - result
+// Return:	size_t - size of target in bytes
+
+size_t acpi_eval_result(acpi_object_t *destination, acpi_state_t *state, uint8_t *target, uint64_t integer)
+{
+	destination->type = ACPI_INTEGER;
+	destination->integer = integer;
+
+	if(target[0] == ZERO_OP)		// NullName, nothing to store
 		return 1;
-	} else if(object[0] >= ARG0_OP && object[0] <= ARG6_OP)
+
+	return acpi_write_object(target, destination, state);
+}
+
+// acpi_eval_local(): Evaluates a LocalX
+// Param:	acpi_object_t *destination - copy of the local
+// Param:	acpi_state_t *state - AML VM state
+// Param:	void *data - opcode data
+// Return:	size_t - size in bytes for skipping
+
+size_t acpi_eval_local(acpi_object_t *destination, acpi_state_t *state, void *data)
+{
+	uint8_t *object = (uint8_t*)data;
+	acpi_copy_object(destination, &state->local[object[0] - LOCAL0_OP]);
+	return 1;
+}
+
+// acpi_eval_arg(): Evaluates an ArgX
+// Param:	acpi_object_t *destination - copy of the argument
+// Param:	acpi_state_t *state - AML VM state
+// Param:	void *data - opcode data
+// Return:	size_t - size in bytes for skipping
+
+size_t acpi_eval_arg(acpi_object_t *destination, acpi_state_t *state, void *data)
+{
+	uint8_t *object = (uint8_t*)data;
+	acpi_copy_object(destination, &state->arg[object[0] - ARG0_OP]);
+	return 1;
+}
+
+// acpi_eval_constant(): Evaluates an integer constant or prefixed integer
+// Param:	acpi_object_t *destination - the integer
+// Param:	acpi_state_t *state - AML VM state
+// Param:	void *data - opcode data
+// Return:	size_t - size in bytes for skipping
+
+size_t acpi_eval_constant(acpi_object_t *destination, acpi_state_t *state, void *data)
+{
+	destination->type = ACPI_INTEGER;
+	return acpi_eval_integer((uint8_t*)data, &destination->integer);
+}
+
+// acpi_eval_string(): Evaluates a String
+// Param:	acpi_object_t *destination - the string, pointing into the AML
+// Param:	acpi_state_t *state - AML VM state
+// Param:	void *data - opcode data
+// Return:	size_t - size in bytes for skipping
+
+size_t acpi_eval_string(acpi_object_t *destination, acpi_state_t *state, void *data)
+{
+	uint8_t *object = (uint8_t*)data;
+	destination->type = ACPI_STRING;
+	destination->string = (char*)(&object[1]);
+	return acpi_strlen(destination->string) + 2;	// skip STRINGPREFIX and null terminator
+}
+
+// acpi_eval_package_op(): Evaluates a Package() or VarPackage()
+// Param:	acpi_object_t *destination - the package
+// Param:	acpi_state_t *state - AML VM state
+// Param:	void *data - opcode data
+// Return:	size_t - size in bytes for skipping
+
+size_t acpi_eval_package_op(acpi_object_t *destination, acpi_state_t *state, void *data)
+{
+	return acpins_create_package(destination, state, data);
+}
+
+// acpi_eval_name(): Evaluates a NameString, which may also be a MethodInvokation
+// Param:	acpi_object_t *destination - value of the object or result of the method
+// Param:	acpi_state_t *state - AML VM state
+// Param:	void *data - opcode data
+// Return:	size_t - size in bytes for skipping
+
+size_t acpi_eval_name(acpi_object_t *destination, acpi_state_t *state, void *data)
+{
+	uint8_t *object = (uint8_t*)data;
+	char name[ACPI_MAX_NAME];
+	size_t name_size;
+	acpi_handle_t *handle;
+
+	// resolve the name
+	handle = acpi_exec_resolve_name(&object[0], &name_size);
+	if(!handle)
 	{
-		switch(object[0])
-		{
-		case ARG0_OP:
-			destination_reg = &state->arg[0];
-			break;
-		case ARG1_OP:
-			destination_reg = &state->arg[1];
-			break;
-		case ARG2_OP:
-			destination_reg = &state->arg[2];
-			break;
-		case ARG3_OP:
-			destination_reg = &state->arg[3];
-			break;
-		case ARG4_OP:
-			destination_reg = &state->arg[4];
-			break;
-		case ARG5_OP:
-			destination_reg = &state->arg[5];
-			break;
-		case ARG6_OP:
-			destination_reg = &state->arg[6];
-			break;
-		}
-
-		acpi_copy_object(destination, destination_reg);
-		return 1;
+		acpins_resolve_path(name, &object[0]);
+		acpi_panic("acpi: undefined reference %s\n", name);
 	}
 
-	// try integer
-	integer_size = acpi_eval_integer(object, &integer);
-	if(integer_size != 0)
-	{
-		destination->type = ACPI_INTEGER;
-		destination->integer = integer;
-		return_size = integer_size;
-	} else if(object[0] == STRINGPREFIX)
-	{
-		// try string
-		destination->type = ACPI_STRING;
-		destination->string = (char*)(&object[1]);
-		return_size = acpi_strlen(destination->string);
-		return_size += 2;		// skip STRINGPREFIX and null terminator
-	} else if(object[0] == PACKAGE_OP)
-	{
-		// package
-		destination->type = ACPI_PACKAGE;
-		destination->package = acpi_calloc(sizeof(acpi_object_t), ACPI_MAX_PACKAGE_ENTRIES);
-		destination->package_size = acpins_create_package(destination->package, object);
-		acpi_parse_pkgsize(&object[1], &return_size);
-		return_size++;		// skip PACKAGE_OP
-	} else if(object[0] == BUFFER_OP)
+	// could be a named object
+	if(handle->type == ACPI_NAMESPACE_NAME)
 	{
-		// buffer
-		return_size += acpi_exec_buffer(destination, state, object);
-	} else if(acpi_is_name(object[0]))
+		acpins_read_name(destination, handle);
+		return name_size;
+	} else if(handle->type == ACPI_NAMESPACE_METHOD)
 	{
-		// it's a NameSpec
-		// resolve the name
-		name_size = acpins_resolve_path(name, &object[0]);
-		handle = acpi_exec_resolve(name);
-		if(!handle)
-		{
-			acpi_panic("acpi: undefined reference %s\n", name);
-		}
-
-		// could be a named object
-		if(handle->type == ACPI_NAMESPACE_NAME)
-		{
-			acpi_copy_object(destination, &handle->object);
-			return_size += name_size;
-		} else if(handle->type == ACPI_NAMESPACE_METHOD)
-			// or a MethodInvokation
-			return_size += acpi_methodinvoke(&object[0], state, destination);
-		else if(handle->type == ACPI_NAMESPACE_FIELD || handle->type == ACPI_NAMESPACE_INDEXFIELD)
-		{
-			// or an Operation Region Field
-			// This is what's interesting, because it lets AML do I/O
-			// accesses via I/O ports and MMIO
-			acpi_read_opregion(destination, handle);
-			return_size += name_size;
-		} else
-		{
-			acpi_panic("acpi: undefined behavior when path doesn't resolve into valid data or code.\n");
-		}
-	} else if(object[0] == SIZEOF_OP)
+		// or a MethodInvokation
+		return acpi_methodinvoke(&object[0], state, destination);
+	} else if(handle->type == ACPI_NAMESPACE_FIELD || handle->type == ACPI_NAMESPACE_INDEXFIELD)
 	{
-		// try sizeof
-		return_size++;
-		object++;
-		if(object[0] >= LOCAL0_OP && object[0] <= LOCAL7_OP)
-		{
-			return_size++;
-
-			switch(object[0])
-			{
-			case LOCAL0_OP:
-				sizeof_object = &state->local[0];
-				break;
-			case LOCAL1_OP:
-				sizeof_object = &state->local[1];
-				break;
-			case LOCAL2_OP:
-				sizeof_object = &state->local[2];
-				break;
-			case LOCAL3_OP:
-				sizeof_object = &state->local[3];
-				break;
-			case LOCAL4_OP:
-				sizeof_object = &state->local[4];
-				break;
-			case LOCAL5_OP:
-				sizeof_object = &state->local[5];
-				break;
-			case LOCAL6_OP:
-				sizeof_object = &state->local[6];
-				break;
-			case LOCAL7_OP:
-				sizeof_object = &state->local[7];
-				break;
-			}
-		} else if(object[0] >= ARG0_OP && object[0] <= ARG6_OP)
-		{
-			return_size++;
-
-			switch(object[0])
-			{
-			case ARG0_OP:
-				sizeof_object = &state->arg[0];
-				break;
-			case ARG1_OP:
-				sizeof_object = &state->arg[1];
-				break;
-			case ARG2_OP:
-				sizeof_object = &state->arg[2];
-				break;
-			case ARG3_OP:
-				sizeof_object = &state->arg[3];
-				break;
-			case ARG4_OP:
-				sizeof_object = &state->arg[4];
-				break;
-			case ARG5_OP:
-				sizeof_object = &state->arg[5];
-				break;
-			case ARG6_OP:
-				sizeof_object = &state->arg[6];
-				break;
-			}
-		} else if(acpi_is_name(object[0]))
-		{
-			acpi_panic("TO-DO: Implement SizeOf for namespec\n");
-			/*sizeof_object = acpi_malloc(sizeof(acpi_object_t));
-			return_size += acpi_eval_object(sizeof_object, state, &object[0]);*/
-		} else
-		{
-			acpi_panic("acpi: undefined object for SizeOf\n");
-		}
-
-		// now determine the actual size
-		destination->type = ACPI_INTEGER;
+		// or an Operation Region Field
+		// This is what's interesting, because it lets AML do I/O
+		// accesses via I/O ports and MMIO
+		acpi_read_opregion(destination, handle);
+		return name_size;
+	}
 
-		if(sizeof_object->type == ACPI_INTEGER)
-			destination->integer = 8;	// treat all integers like qwords
-		else if(sizeof_object->type == ACPI_STRING)
-			destination->integer = acpi_strlen(sizeof_object->string);
-		else if(sizeof_object->type == ACPI_PACKAGE)
-			destination->integer = sizeof_object->package_size;
-		else if(sizeof_object->type == ACPI_BUFFER)
-			destination->integer = sizeof_object->buffer_size;
-
-		else
-		{
-			acpi_panic("acpi: can't perform SizeOf on object type %d\n", sizeof_object->type);
-		}
-	} else if(object[0] == DEREF_OP)
-	{
-		// what a fucking waste of space DeRef is.
-		return_size = acpi_eval_object(destination, state, &object[1]) + 1;
-	} else if(object[0] == INDEX_OP)
+	acpi_panic("acpi: undefined behavior when path doesn't resolve into valid data or code.\n");
+}
+
+// acpi_eval_sizeof(): Evaluates a SizeOf() opcode
+// Param:	acpi_object_t *destination - the size
+// Param:	acpi_state_t *state - AML VM state
+// Param:	void *data - opcode data
+// Return:	size_t - size in bytes for skipping
+
+size_t acpi_eval_sizeof(acpi_object_t *destination, acpi_state_t *state, void *data)
+{
+	uint8_t *object = (uint8_t*)data;
+	acpi_object_t *sizeof_object;
+	object++;
+
+	if(object[0] >= LOCAL0_OP && object[0] <= LOCAL7_OP)
+		sizeof_object = &state->local[object[0] - LOCAL0_OP];
+	else if(object[0] >= ARG0_OP && object[0] <= ARG6_OP)
+		sizeof_object = &state->arg[object[0] - ARG0_OP];
+	else if(acpi_is_name(object[0]))
 	{
-		return_size = 2;
-		object++;
-
-		size_t index_size;
-
-		acpi_object_t ref, index;
-		index_size = acpi_eval_object(&ref, state, &object[0]);
-		return_size += index_size;
-		object += index_size;
-
-		index_size = acpi_eval_object(&index, state, &object[0]);
-		return_size += index_size;
-
-		if(ref.type == ACPI_STRING)
-		{
-			destination->type = ACPI_INTEGER;
-			destination->integer = (uint64_t)ref.string[index.integer];
-		} else if(ref.type == ACPI_BUFFER)
-		{
-			destination->type = ACPI_INTEGER;
-			uint8_t *byte = (uint8_t*)ref.buffer;
-			destination->integer = (uint64_t)byte[0];
-		} else if(ref.type == ACPI_PACKAGE)
-		{
-			acpi_copy_object(destination, &ref.package[index.integer]);
-		} else
-		{
-			acpi_panic("TO-DO: More Index() objects\n");
-		}
-	} else if(object[0] == LNOT_OP)
+		acpi_panic("TO-DO: Implement SizeOf for namespec\n");
+	} else
 	{
-		return_size = 1;
-		object++;
+		acpi_panic("acpi: undefined object for SizeOf\n");
+	}
 
-		return_size += acpi_eval_object(&n1, state, &object[0]);
-		destination->type = ACPI_INTEGER;
-		if(n1.integer == 0)
-			destination->integer = 1;
-		else
-			destination->integer = 0;
-	} else if(object[0] == LAND_OP)
+	// now determine the actual size
+	destination->type = ACPI_INTEGER;
+
+	if(sizeof_object->type == ACPI_INTEGER)
+		destination->integer = 8;	// treat all integers like qwords
+	else if(sizeof_object->type == ACPI_STRING)
+		destination->integer = acpi_strlen(sizeof_object->string);
+	else if(sizeof_object->type == ACPI_PACKAGE)
+		destination->integer = sizeof_object->package_size;
+	else if(sizeof_object->type == ACPI_BUFFER)
+		destination->integer = sizeof_object->buffer_size;
+	else
 	{
-		return_size = 1;
-		object++;
+		acpi_panic("acpi: can't perform SizeOf on object type %d\n", sizeof_object->type);
+	}
+
+	return 2;
+}
 
-		integer_size = acpi_eval_object(&n1, state, &object[0]);
-		return_size += integer_size;
-		object += integer_size;
+// acpi_eval_deref(): Evaluates a DerefOf() opcode
+// Param:	acpi_object_t *destination - the object referred to
+// Param:	acpi_state_t *state - AML VM state
+// Param:	void *data - opcode data
+// Return:	size_t - size in bytes for skipping
 
-		integer_size = acpi_eval_object(&n2, state, &object[0]);
-		return_size += integer_size;
+size_t acpi_eval_deref(acpi_object_t *destination, acpi_state_t *state, void *data)
+{
+	// what a fucking waste of space DeRef is.
+	return acpi_eval_object(destination, state, (uint8_t*)data + 1) + 1;
+}
 
-		destination->type = ACPI_INTEGER;
+// acpi_eval_index(): Evaluates an Index() opcode
+// Param:	acpi_object_t *destination - the element
+// Param:	acpi_state_t *state - AML VM state
+// Param:	void *data - opcode data
+// Return:	size_t - size in bytes for skipping
+
+size_t acpi_eval_index(acpi_object_t *destination, acpi_state_t *state, void *data)
+{
+	uint8_t *object = (uint8_t*)data;
+	acpi_object_t ref, index;
+	size_t return_size = acpi_eval_operands(state, &object[1], &ref, &index) + 2;
 
-		if(n1.integer != 0 && n2.integer != 0)
-			destination->integer = 1;
-		else
-			destination->integer = 0;
-	} else if(object[0] == LEQUAL_OP)
+	if(ref.type == ACPI_STRING)
+	{
+		destination->type = ACPI_INTEGER;
+		destination->integer = (uint64_t)ref.string[index.integer];
+	} else if(ref.type == ACPI_BUFFER)
+	{
+		destination->type = ACPI_INTEGER;
+		uint8_t *byte = (uint8_t*)ref.buffer;
+		destination->integer = (uint64_t)byte[index.integer];
+	} else if(ref.type == ACPI_PACKAGE)
+	{
+		acpi_copy_object(destination, &ref.package[index.integer]);
+	} else
 	{
-		return_size = 1;
-		object++;
+		acpi_panic("TO-DO: More Index() objects\n");
+	}
 
-		integer_size = acpi_eval_object(&n1, state, &object[0]);
-		return_size += integer_size;
-		object += integer_size;
+	acpi_free_object(&ref);
+	return return_size;
+}
 
-		integer_size = acpi_eval_object(&n2, state, &object[0]);
-		return_size += integer_size;
+// acpi_eval_lnot(): Evaluates an LNot() opcode
+// Param:	acpi_object_t *destination - 1 or 0
+// Param:	acpi_state_t *state - AML VM state
+// Param:	void *data - opcode data
+// Return:	size_t - size in bytes for skipping
 
-		destination->type = ACPI_INTEGER;
+size_t acpi_eval_lnot(acpi_object_t *destination, acpi_state_t *state, void *data)
+{
+	acpi_object_t n1;
+	size_t return_size = acpi_eval_object(&n1, state, (uint8_t*)data + 1) + 1;
 
-		if(n1.integer == n2.integer)
-			destination->integer = 1;
-		else
-			destination->integer = 0;
-	} else if(object[0] == LGREATER_OP)
-	{
-		return_size = 1;
-		object++;
+	destination->type = ACPI_INTEGER;
+	destination->integer = (n1.integer == 0) ? 1 : 0;
+	return return_size;
+}
 
-		integer_size = acpi_eval_object(&n1, state, &object[0]);
-		return_size += integer_size;
-		object += integer_size;
+// acpi_eval_land(): Evaluates an LAnd() opcode
+// Param:	acpi_object_t *destination - 1 or 0
+// Param:	acpi_state_t *state - AML VM state
+// Param:	void *data - opcode data
+// Return:	size_t - size in bytes for skipping
 
-		integer_size = acpi_eval_object(&n2, state, &object[0]);
-		return_size += integer_size;
+size_t acpi_eval_land(acpi_object_t *destination, acpi_state_t *state, void *data)
+{
+	acpi_object_t n1, n2;
+	size_t return_size = acpi_eval_operands(state, (uint8_t*)data + 1, &n1, &n2) + 1;
 
-		destination->type = ACPI_INTEGER;
-		if(n1.integer > n2.integer)
-			destination->integer = 1;
-		else
-			destination->integer = 0;
-	} else if(object[0] == LLESS_OP)
-	{
-		return_size = 1;
-		object++;
+	destination->type = ACPI_INTEGER;
+	destination->integer = (n1.integer != 0 && n2.integer != 0) ? 1 : 0;
+	return return_size;
+}
 
-		integer_size = acpi_eval_object(&n1, state, &object[0]);
-		return_size += integer_size;
-		object += integer_size;
+// acpi_eval_lor(): Evaluates an LOr() opcode
+// Param:	acpi_object_t *destination - 1 or 0
+// Param:	acpi_state_t *state - AML VM state
+// Param:	void *data - opcode data
+// Return:	size_t - size in bytes for skipping
 
-		integer_size = acpi_eval_object(&n2, state, &object[0]);
-		return_size += integer_size;
+size_t acpi_eval_lor(acpi_object_t *destination, acpi_state_t *state, void *data)
+{
+	acpi_object_t n1, n2;
+	size_t return_size = acpi_eval_operands(state, (uint8_t*)data + 1, &n1, &n2) + 1;
 
-		destination->type = ACPI_INTEGER;
-		if(n1.integer < n2.integer)
-			destination->integer = 1;
-		else
-			destination->integer = 0;
-	} else if(object[0] == LOR_OP)
-	{
-		return_size = 1;
-		object++;
+	destination->type = ACPI_INTEGER;
+	destination->integer = (n1.integer != 0 || n2.integer != 0) ? 1 : 0;
+	return return_size;
+}
 
-		integer_size = acpi_eval_object(&n1, state, &object[0]);
-		return_size += integer_size;
-		object += integer_size;
+// acpi_eval_lequal(): Evaluates an LEqual() opcode
+// Param:	acpi_object_t *destination - 1 or 0
+// Param:	acpi_state_t *state - AML VM state
+// Param:	void *data - opcode data
+// Return:	size_t - size in bytes for skipping
 
-		integer_size = acpi_eval_object(&n2, state, &object[0]);
-		return_size += integer_size;
+size_t acpi_eval_lequal(acpi_object_t *destination, acpi_state_t *state, void *data)
+{
+	acpi_object_t n1, n2;
+	size_t return_size = acpi_eval_operands(state, (uint8_t*)data + 1, &n1, &n2) + 1;
 
-		destination->type = ACPI_INTEGER;
-		if(n1.integer == 0 || n2.integer == 0)
-			destination->integer = 1;
-		else
-			destination->integer = 0;
-	} else if(object[0] == AND_OP)
-	{
-		return_size = 2;
-		object++;
+	destination->type = ACPI_INTEGER;
+	destination->integer = (n1.integer == n2.integer) ? 1 : 0;
+	return return_size;
+}
 
-		integer_size = acpi_eval_object(&n1, state, &object[0]);
-		return_size += integer_size;
-		object += integer_size;
+// acpi_eval_lgreater(): Evaluates an LGreater() opcode
+// Param:	acpi_object_t *destination - 1 or 0
+// Param:	acpi_state_t *state - AML VM state
+// Param:	void *data - opcode data
+// Return:	size_t - size in bytes for skipping
 
-		integer_size = acpi_eval_object(&n2, state, &object[0]);
-		return_size += integer_size;
+size_t acpi_eval_lgreater(acpi_object_t *destination, acpi_state_t *state, void *data)
+{
+	acpi_object_t n1, n2;
+	size_t return_size = acpi_eval_operands(state, (uint8_t*)data + 1, &n1, &n2) + 1;
 
-		destination->type = ACPI_INTEGER;
-		destination->integer = n1.integer & n2.integer;
-	} else if(object[0] == ADD_OP)
-	{
-		return_size = 2;
-		object++;
+	destination->type = ACPI_INTEGER;
+	destination->integer = (n1.integer > n2.integer) ? 1 : 0;
+	return return_size;
+}
 
-		integer_size = acpi_eval_object(&n1, state, &object[0]);
-		return_size += integer_size;
-		object += integer_size;
+// acpi_eval_lless(): Evaluates an LLess() opcode
+// Param:	acpi_object_t *destination - 1 or 0
+// Param:	acpi_state_t *state - AML VM state
+// Param:	void *data - opcode data
+// Return:	size_t - size in bytes for skipping
 
-		integer_size = acpi_eval_object(&n2, state, &object[0]);
-		return_size += integer_size;
+size_t acpi_eval_lless(acpi_object_t *destination, acpi_state_t *state, void *data)
+{
+	acpi_object_t n1, n2;
+	size_t return_size = acpi_eval_operands(state, (uint8_t*)data + 1, &n1, &n2) + 1;
 
-		destination->type = ACPI_INTEGER;
-		destination->integer = n1.integer + n2.integer;
-	} else if(object[0] == OR_OP)
-	{
-		return_size = 2;
-		object++;
+	destination->type = ACPI_INTEGER;
+	destination->integer = (n1.integer < n2.integer) ? 1 : 0;
+	return return_size;
+}
 
-		integer_size = acpi_eval_object(&n1, state, &object[0]);
-		return_size += integer_size;
-		object += integer_size;
+// acpi_eval_and(): Evaluates an And() opcode and stores it in its target
+// Param:	acpi_object_t *destination - the result
+// Param:	acpi_state_t *state - AML VM state
+// Param:	void *data - opcode data
+// Return:	size_t - size in bytes for skipping
 
-		integer_size = acpi_eval_object(&n2, state, &object[0]);
-		return_size += integer_size;
+size_t acpi_eval_and(acpi_object_t *destination, acpi_state_t *state, void *data)
+{
+	uint8_t *object = (uint8_t*)data;
+	acpi_object_t n1, n2;
+	size_t return_size = acpi_eval_operands(state, &object[1], &n1, &n2) + 1;
 
-		destination->type = ACPI_INTEGER;
-		destination->integer = n1.integer | n2.integer;
-	} else if(object[0] == SUBTRACT_OP)
-	{
-		return_size = 2;
-		object++;
+	return return_size + acpi_eval_result(destination, state, &object[return_size], n1.integer & n2.integer);
+}
 
-		integer_size = acpi_eval_object(&n1, state, &object[0]);
-		return_size += integer_size;
-		object += integer_size;
+// acpi_eval_add(): Evaluates an Add() opcode and stores it in its target
+// Param:	acpi_object_t *destination - the result
+// Param:	acpi_state_t *state - AML VM state
+// Param:	void *data - opcode data
+// Return:	size_t - size in bytes for skipping
 
-		integer_size = acpi_eval_object(&n2, state, &object[0]);
-		return_size += integer_size;
+size_t acpi_eval_add(acpi_object_t *destination, acpi_state_t *state, void *data)
+{
+	uint8_t *object = (uint8_t*)data;
+	acpi_object_t n1, n2;
+	size_t return_size = acpi_eval_operands(state, &object[1], &n1, &n2) + 1;
 
-		destination->type = ACPI_INTEGER;
-		destination->integer = n1.integer - n2.integer;
-	} else if(object[0] == NOT_OP)
-	{
-		return_size = 2;
-		object++;
+	return return_size + acpi_eval_result(destination, state, &object[return_size], n1.integer + n2.integer);
+}
 
-		integer_size = acpi_eval_object(&n1, state, &object[0]);
-		return_size += integer_size;
+// acpi_eval_or(): Evaluates an Or() opcode and stores it in its target
+// Param:	acpi_object_t *destination - the result
+// Param:	acpi_state_t *state - AML VM state
+// Param:	void *data - opcode data
+// Return:	size_t - size in bytes for skipping
 
-		destination->type = ACPI_INTEGER;
-		destination->integer = ~n1.integer;
-	} else if(object[0] == XOR_OP)
-	{
-		return_size = 2;
-		object++;
+size_t acpi_eval_or(acpi_object_t *destination, acpi_state_t *state, void *data)
+{
+	uint8_t *object = (uint8_t*)data;
+	acpi_object_t n1, n2;
+	size_t return_size = acpi_eval_operands(state, &object[1], &n1, &n2) + 1;
 
-		integer_size = acpi_eval_object(&n1, state, &object[0]);
-		return_size += integer_size;
-		object += integer_size;
+	return return_size + acpi_eval_result(destination, state, &object[return_size], n1.integer | n2.integer);
+}
 
-		integer_size = acpi_eval_object(&n2, state, &object[0]);
-		return_size += integer_size;
+// acpi_eval_subtract(): Evaluates a Subtract() opcode and stores it in its target
+// Param:	acpi_object_t *destination - the result
+// Param:	acpi_state_t *state - AML VM state
+// Param:	void *data - opcode data
+// Return:	size_t - size in bytes for skipping
 
-		destination->type = ACPI_INTEGER;
-		destination->integer = n1.integer ^ n2.integer;
-	} else if(object[0] == SHL_OP)
-	{
-		return_size = 2;
-		object++;
+size_t acpi_eval_subtract(acpi_object_t *destination, acpi_state_t *state, void *data)
+{
+	uint8_t *object = (uint8_t*)data;
+	acpi_object_t n1, n2;
+	size_t return_size = acpi_eval_operands(state, &object[1], &n1, &n2) + 1;
 
-		integer_size = acpi_eval_object(&n1, state, &object[0]);
-		return_size += integer_size;
-		object += integer_size;
+	return return_size + acpi_eval_result(destination, state, &object[return_size], n1.integer - n2.integer);
+}
 
-		integer_size = acpi_eval_object(&n2, state, &object[0]);
-		return_size += integer_size;
+// acpi_eval_xor(): Evaluates an XOr() opcode and stores it in its target
+// Param:	acpi_object_t *destination - the result
+// Param:	acpi_state_t *state - AML VM state
+// Param:	void *data - opcode data
+// Return:	size_t - size in bytes for skipping
 
-		destination->type = ACPI_INTEGER;
-		destination->integer = n1.integer << n2.integer;
-	} else if(object[0] == SHR_OP)
-	{
-		return_size = 2;
-		object++;
+size_t acpi_eval_xor(acpi_object_t *destination, acpi_state_t *state, void *data)
+{
+	uint8_t *object = (uint8_t*)data;
+	acpi_object_t n1, n2;
+	size_t return_size = acpi_eval_operands(state, &object[1], &n1, &n2) + 1;
 
-		integer_size = acpi_eval_object(&n1, state, &object[0]);
-		return_size += integer_size;
-		object += integer_size;
+	return return_size + acpi_eval_result(destination, state, &object[return_size], n1.integer ^ n2.integer);
+}
 
-		integer_size = acpi_eval_object(&n2, state, &object[0]);
-		return_size += integer_size;
+// acpi_eval_shl(): Evaluates a ShiftLeft() opcode and stores it in its target
+// Param:	acpi_object_t *destination - the result
+// Param:	acpi_state_t *state - AML VM state
+// Param:	void *data - opcode data
+// Return:	size_t - size in bytes for skipping
 
-		destination->type = ACPI_INTEGER;
-		destination->integer = n1.integer >> n2.integer;
-	} else if(object[0] == EXTOP_PREFIX && object[1] == CONDREF_OP)
-	{
-		return_size = 3;
-		object += 2;
+size_t acpi_eval_shl(acpi_object_t *destination, acpi_state_t *state, void *data)
+{
+	uint8_t *object = (uint8_t*)data;
+	acpi_object_t n1, n2;
+	size_t return_size = acpi_eval_operands(state, &object[1], &n1, &n2) + 1;
 
-		name_size = acpins_resolve_path(name, &object[0]);
-		return_size += name_size;
+	return return_size + acpi_eval_result(destination, state, &object[return_size], n1.integer << n2.integer);
+}
 
-		acpi_handle_t *handle = acpi_exec_resolve(name);
-		destination->type = ACPI_INTEGER;
+// acpi_eval_shr(): Evaluates a ShiftRight() opcode and stores it in its target
+// Param:	acpi_object_t *destination - the result
+// Param:	acpi_state_t *state - AML VM state
+// Param:	void *data - opcode data
+// Return:	size_t - size in bytes for skipping
 
-		if(!handle)
-			destination->integer = 0;
-		else
-			destination->integer = 1;
-	} else if(object[0] == MULTIPLY_OP)
-	{
-		return_size = 2;
-		object++;
+size_t acpi_eval_shr(acpi_object_t *destination, acpi_state_t *state, void *data)
+{
+	uint8_t *object = (uint8_t*)data;
+	acpi_object_t n1, n2;
+	size_t return_size = acpi_eval_operands(state, &object[1], &n1, &n2) + 1;
+
+	return return_size + acpi_eval_result(destination, state, &object[return_size], n1.integer >> n2.integer);
+}
+
+// acpi_eval_multiply(): Evaluates a Multiply() opcode and stores it in its target
+// Param:	acpi_object_t *destination - the result
+// Param:	acpi_state_t *state - AML VM state
+// Param:	void *data - opcode data
+// Return:	size_t - size in bytes for skipping
 
-		integer_size = acpi_eval_object(&n1, state, &object[0]);
-		return_size += integer_size;
-		object += integer_size;
+size_t acpi_eval_multiply(acpi_object_t *destination, acpi_state_t *state, void *data)
+{
+	uint8_t *object = (uint8_t*)data;
+	acpi_object_t n1, n2;
+	size_t return_size = acpi_eval_operands(state, &object[1], &n1, &n2) + 1;
 
-		integer_size = acpi_eval_object(&n2, state, &object[0]);
-		return_size += integer_size;
+	return return_size + acpi_eval_result(destination, state, &object[return_size], n1.integer * n2.integer);
+}
 
-		destination->type = ACPI_INTEGER;
-		destination->integer = n1.integer * n2.integer;
-	} else if(object[0] == DIVIDE_OP)
-	{
-		return_size = 3;
-		object++;
+// acpi_eval_not(): Evaluates a Not() opcode and stores it in its target
+// Param:	acpi_object_t *destination - the result
+// Param:	acpi_state_t *state - AML VM state
+// Param:	void *data - opcode data
+// Return:	size_t - size in bytes for skipping
 
-		integer_size = acpi_eval_object(&n1, state, &object[0]);
-		return_size += integer_size;
-		object += integer_size;
+size_t acpi_eval_not(acpi_object_t *destination, acpi_state_t *state, void *data)
+{
+	uint8_t *object = (uint8_t*)data;
+	acpi_object_t n1;
+	size_t return_size = acpi_eval_object(&n1, state, &object[1]) + 1;
 
-		integer_size = acpi_eval_object(&n2, state, &object[0]);
-		return_size += integer_size;
-		object += integer_size;
+	return return_size + acpi_eval_result(destination, state, &object[return_size], ~n1.integer);
+}
 
-		acpi_object_t mod, quo;
-		mod.type = ACPI_INTEGER;
-		quo.type = ACPI_INTEGER;
+// acpi_eval_divide(): Evaluates a Divide() opcode and stores the remainder and quotient in their targets
+// Param:	acpi_object_t *destination - the quotient
+// Param:	acpi_state_t *state - AML VM state
+// Param:	void *data - opcode data
+// Return:	size_t - size in bytes for skipping
 
-		mod.integer = n1.integer % n2.integer;
-		quo.integer = n1.integer / n2.integer;
+size_t acpi_eval_divide(acpi_object_t *destination, acpi_state_t *state, void *data)
+{
+	uint8_t *object = (uint8_t*)data;
+	acpi_object_t n1, n2, mod;
+	size_t return_size = acpi_eval_operands(state, &object[1], &n1, &n2) + 1;
 
-		integer_size = acpi_write_object(&object[0], &mod, state);
-		return_size += integer_size;
-		object += integer_size;
+	// remainder first, then the quotient, which is also the result
+	return_size += acpi_eval_result(&mod, state, &object[return_size], n1.integer % n2.integer);
+	return return_size + acpi_eval_result(destination, state, &object[return_size], n1.integer / n2.integer);
+}
 
-		integer_size = acpi_write_object(&object[0], &quo, state);
-		return_size += integer_size;
+// acpi_eval_condref(): Evaluates a CondRefOf() opcode
+// Param:	acpi_object_t *destination - 1 if the object exists, 0 otherwise
+// Param:	acpi_state_t *state - AML VM state
+// Param:	void *data - opcode data
+// Return:	size_t - size in bytes for skipping
 
-		destination->type = ACPI_INTEGER;
-		destination->integer = n1.integer / n2.integer;
-	} else
-	{
-		acpi_panic("acpi: undefined opcode, sequence: %xb %xb %xb %xb\n", object[0], object[1], object[2], object[3]);
-	}
+size_t acpi_eval_condref(acpi_object_t *destination, acpi_state_t *state, void *data)
+{
+	uint8_t *object = (uint8_t*)data;
+	char name[ACPI_MAX_NAME];
+	size_t return_size = acpins_resolve_path(name, &object[2]) + 3;	// EXTOP_PREFIX, CONDREF_OP and target
 
+	destination->type = ACPI_INTEGER;
+	destination->integer = acpi_exec_resolve(name) ? 1 : 0;
 	return return_size;
 }
 
+// Opcode table, for evaluating opcodes as operands and executing them as statements
+// Control flow opcodes are not here, because acpi_exec() handles them itself
+acpi_opcode_t acpi_opcodes[256] =
+{
+	[ZERO_OP] = { .eval = acpi_eval_constant, .exec = acpi_exec_nop },
+	[ONE_OP] = { .eval = acpi_eval_constant, .exec = acpi_exec_nop },
+	[ONES_OP] = { .eval = acpi_eval_constant, .exec = acpi_exec_nop },
+	[NOP_OP] = { .exec = acpi_exec_nop },
+	[BYTEPREFIX] = { .eval = acpi_eval_constant },
+	[WORDPREFIX] = { .eval = acpi_eval_constant },
+	[DWORDPREFIX] = { .eval = acpi_eval_constant },
+	[QWORDPREFIX] = { .eval = acpi_eval_constant },
+	[STRINGPREFIX] = { .eval = acpi_eval_string },
+	[PACKAGE_OP] = { .eval = acpi_eval_package_op },
+	[VARPACKAGE_OP] = { .eval = acpi_eval_package_op },
+	[BUFFER_OP] = { .eval = acpi_exec_buffer },
+	[NAME_OP] = { .exec = acpi_exec_name },
+
+	// NameStrings, see acpi_is_name()
+	['0' ... 'Z'] = { .eval = acpi_eval_name, .exec = acpi_exec_invoke },
+	['_'] = { .eval = acpi_eval_name, .exec = acpi_exec_invoke },
+	[ROOT_CHAR] = { .eval = acpi_eval_name, .exec = acpi_exec_invoke },
+	[PARENT_CHAR] = { .eval = acpi_eval_name, .exec = acpi_exec_invoke },
+	[DUAL_PREFIX] = { .eval = acpi_eval_name, .exec = acpi_exec_invoke },
+	[MULTI_PREFIX] = { .eval = acpi_eval_name, .exec = acpi_exec_invoke },
+
+	[LOCAL0_OP ... LOCAL7_OP] = { .eval = acpi_eval_local },
+	[ARG0_OP ... ARG6_OP] = { .eval = acpi_eval_arg },
+
+	[STORE_OP] = { .exec = acpi_exec_store },
+	[ADD_OP] = { .eval = acpi_eval_add, .exec = acpi_exec_add },
+	[SUBTRACT_OP] = { .eval = acpi_eval_subtract, .exec = acpi_exec_subtract },
+	[INCREMENT_OP] = { .exec = acpi_exec_increment },
+	[DECREMENT_OP] = { .exec = acpi_exec_decrement },
+	[MULTIPLY_OP] = { .eval = acpi_eval_multiply, .exec = acpi_exec_multiply },
+	[DIVIDE_OP] = { .eval = acpi_eval_divide, .exec = acpi_exec_divide },
+	[SHL_OP] = { .eval = acpi_eval_shl, .exec = acpi_exec_shl },
+	[SHR_OP] = { .eval = acpi_eval_shr, .exec = acpi_exec_shr },
+	[AND_OP] = { .eval = acpi_eval_and, .exec = acpi_exec_and },
+	[OR_OP] = { .eval = acpi_eval_or, .exec = acpi_exec_or },
+	[XOR_OP] = { .eval = acpi_eval_xor, .exec = acpi_exec_xor },
+	[NOT_OP] = { .eval = acpi_eval_not, .exec = acpi_exec_not },
+	[DEREF_OP] = { .eval = acpi_eval_deref },
+	[SIZEOF_OP] = { .eval = acpi_eval_sizeof },
+	[INDEX_OP] = { .eval = acpi_eval_index },
+	[DWORDFIELD_OP] = { .exec = acpi_exec_dwordfield },
+	[WORDFIELD_OP] = { .exec = acpi_exec_wordfield },
+	[BYTEFIELD_OP] = { .exec = acpi_exec_bytefield },
+	[QWORDFIELD_OP] = { .exec = acpi_exec_qwordfield },
+	[LAND_OP] = { .eval = acpi_eval_land },
+	[LOR_OP] = { .eval = acpi_eval_lor },
+	[LNOT_OP] = { .eval = acpi_eval_lnot },
+	[LEQUAL_OP] = { .eval = acpi_eval_lequal },
+	[LGREATER_OP] = { .eval = acpi_eval_lgreater },
+	[LLESS_OP] = { .eval = acpi_eval_lless },
+};
+
+// Same as above, for the opcodes after EXTOP_PREFIX
+acpi_opcode_t acpi_extopcodes[256] =
+{
+	[CONDREF_OP] = { .eval = acpi_eval_condref },
+	[STALL_OP] = { .exec = acpi_exec_stall },
+	[SLEEP_OP] = { .exec = acpi_exec_sleep },
+	[ACQUIRE_OP] = { .eval = acpi_eval_acquire, .exec = acpi_exec_acquire },
+	[SIGNAL_OP] = { .exec = acpi_exec_signal },
+	[WAIT_OP] = { .eval = acpi_eval_wait, .exec = acpi_exec_wait },
+	[RESET_OP] = { .exec = acpi_exec_reset },
+	[RELEASE_OP] = { .exec = acpi_exec_release },
+	[TIMER_OP] = { .eval = acpi_eval_timer },
+};
+
 // acpi_eval(): Returns an object
 // Param:	acpi_object_t *destination - where to store object
 // Param:	char *path - path of object
@@ -664,14 +714,15 @@ int acpi_eval(acpi_object_t *destination, char *path)
 
 	if(handle->type == ACPI_NAMESPACE_NAME)
 	{
-		acpi_copy_object(destination, &handle->object);
+		acpins_read_name(destination, handle);
 		return 0;
 	} else if(handle->type == ACPI_NAMESPACE_METHOD)
 	{
-		acpi_state_t state;
-		acpi_memset(&state, 0, sizeof(acpi_state_t));
-		acpi_strcpy(state.name, path);
-		return acpi_exec_method(&state, destination);
+		acpi_state_t *state = acpi_push_state(path);
+
+		int status = acpi_exec_method(state, destination);
+		acpi_pop_state(state);
+		return status;
 	}
 
 	return 1;
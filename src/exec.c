@@ -13,38 +13,62 @@
 
 int acpi_exec(uint8_t *, size_t, acpi_state_t *, acpi_object_t *);
 
+#ifndef ACPI_THREADS
+acpi_context_t acpi_default_context;
+#endif
+
+#ifdef ACPI_BUDGET
+acpi_budget_t acpi_budget;				// no limits until the OS sets some
+#endif
+
 char acpi_emulated_os[] = "Windows 2015";		// Windows 10
 uint64_t acpi_implemented_version = 2;			// ACPI 2.0
 
+// acpi_exec_osi(): Decides what _OSI() returns for an OS name
+// Param:	char *name - OS name or feature string
+// Return:	uint32_t - 0xFFFFFFFF when supported, 0 otherwise
+
+uint32_t acpi_exec_osi(char *name)
+{
+	// We have to pretend to be a modern version of Windows,
+	// for AML to let us use its features.
+	if(acpi_strcmp(name, "Windows 2006") == 0)		// Windows Vista
+		return 0xFFFFFFFF;
+	else if(acpi_strcmp(name, "Windows 2009") == 0)		// Windows 7
+		return 0xFFFFFFFF;
+	else if(acpi_strcmp(name, "Windows 2012") == 0)		// Windows 8
+		return 0xFFFFFFFF;
+	else if(acpi_strcmp(name, "Windows 2013") == 0)		// Windows 8.1
+		return 0xFFFFFFFF;
+	else if(acpi_strcmp(name, "Windows 2015") == 0)		// Windows 10
+		return 0xFFFFFFFF;
+
+	else
+		return 0x00000000;	// unsupported OS
+}
+
 // acpi_exec_method(): Finds and executes a control method
 // Param:	acpi_state_t *state - method name and arguments
 // Param:	acpi_object_t *method_return - return value of method
-// Return:	int - 0 on success
+// Return:	int - 0 on success, -1 when it doesn't exist or is Serialized and its mutex can't be
+//		acquired, ACPI_ABORTED when it runs out of its budget
 
 int acpi_exec_method(acpi_state_t *state, acpi_object_t *method_return)
 {
+	acpi_context_t *context = acpi_context();
 	acpi_handle_t *method;
 
+	// only acpi_start_method() sets this, and only for the method it starts
+	int resumable = context->resumable;
+	context->resumable = 0;
+
 	uint32_t osi_return = 0;
 
 	// When executing the _OSI() method, we'll have one parameter which contains
-	// the name of an OS. We have to pretend to be a modern version of Windows,
-	// for AML to let us use its features.
+	// the name of an OS. Compiled methods fold it when the name is a constant.
 	if(acpi_strcmp(state->name, "\\._OSI") == 0)
 	{
-		if(acpi_strcmp(state->arg[0].string, "Windows 2006") == 0)		// Windows Vista
-			osi_return = 0xFFFFFFFF;
-		else if(acpi_strcmp(state->arg[0].string, "Windows 2009") == 0)		// Windows 7
-			osi_return = 0xFFFFFFFF;
-		else if(acpi_strcmp(state->arg[0].string, "Windows 2012") == 0)		// Windows 8
-			osi_return = 0xFFFFFFFF;
-		else if(acpi_strcmp(state->arg[0].string, "Windows 2013") == 0)		// Windows 8.1
-			osi_return = 0xFFFFFFFF;
-		else if(acpi_strcmp(state->arg[0].string, "Windows 2015") == 0)		// Windows 10
-			osi_return = 0xFFFFFFFF;
-
-		else
-			osi_return = 0x00000000;	// unsupported OS
+		osi_return = acpi_exec_osi(state->arg[0].string);
 
 		method_return->type = ACPI_INTEGER;
 		method_return->integer = osi_return;
@@ -57,8 +81,7 @@ int acpi_exec_method(acpi_state_t *state, acpi_object_t *method_return)
 	if(acpi_strcmp(state->name, "\\._OS_") == 0)
 	{
 		method_return->type = ACPI_STRING;
-		method_return->string = acpi_malloc(acpi_strlen(acpi_emulated_os));
-		acpi_strcpy(method_return->string, acpi_emulated_os);
+		method_return->string = acpi_emulated_os;
 
 		acpi_printf("acpi: _OS_ returned '%s'\n", method_return->string);
 		return 0;
@@ -80,9 +103,67 @@ int acpi_exec_method(acpi_state_t *state, acpi_object_t *method_return)
 	if(!method)
 		return -1;
 
+	state->scope = method->index;
+
 	//acpi_printf("acpi: execute control method %s\n", state->name);
 
-	int status = acpi_exec(method->pointer, method->size, state, method_return);
+	// methods aml2c translated to C don't need the IR
+	acpi_ir_t *ir;
+	if(method->method_native)
+		ir = NULL;
+	else
+		ir = acpi_compile_cached(method);		// compile the method the first time it runs
+
+	if(ir && ir->pure && acpi_ir_memo_lookup(ir, state, method_return))
+		return 0;
+
+#ifdef ACPI_BUDGET
+	// the budget covers the method the OS calls and everything it calls
+	if(!context->arena_depth)
+		acpi_budget_start(method);
+#endif
+
+	// compiled methods take the mutex of Serialized methods in their frame,
+	// see acpi_ir_push_frame(); either way, the method doesn't run without it
+	acpi_mutex_t *serialized = NULL;
+	if(!ir && method->mutex)
+	{
+		if(acpi_acquire_mutex(method->mutex, ACPI_FOREVER))
+		{
+			// AML that called it still gets a value
+			method_return->type = ACPI_INTEGER;
+			method_return->integer = 0;
+			return -1;
+		}
+
+		serialized = method->mutex;
+	}
+
+	// temporaries come from the arena, and only the result outlives the call
+	acpi_arena_enter();
+
+	int status;
+	if(method->method_native)
+		status = method->method_native(state, method_return);
+	else if(ir)
+	{
+		context->resumable = resumable;
+		status = acpi_ir_exec(ir, state, method_return);
+	} else
+		status = acpi_exec(method->pointer, method->size, state, method_return);
+
+	// a stopped method keeps its temporaries until it finishes
+	if(status == ACPI_WOULD_BLOCK)
+		return status;
+
+	acpi_arena_leave(state, method_return);
+
+	if(serialized)
+		acpi_release_method_mutex(serialized);
+
+	// mutexes don't outlive the call from the OS, even when AML forgets them
+	if(!context->arena_depth && context->mutexes)
+		acpi_release_mutexes();
 
 	/*acpi_printf("acpi: %s finished, ", state->name);
 
@@ -98,12 +179,160 @@ int acpi_exec_method(acpi_state_t *state, acpi_object_t *method_return)
 	return status;
 }
 
+// acpi_start_method(): Executes a control method, which may stop at a blocking opcode instead of waiting
+// Param:	acpi_state_t *state - method name and arguments, kept until the method finishes
+// Param:	acpi_object_t *method_return - return value of method, kept until the method finishes
+// Return:	int - 0 on success, ACPI_WOULD_BLOCK when it waits for acpi_context()->wait, ACPI_ABORTED
+
+int acpi_start_method(acpi_state_t *state, acpi_object_t *method_return)
+{
+	acpi_context_t *context = acpi_context();
+
+	// compiled methods can stop because their calls are frames rather
+	// than C recursion; methods that run from AML, and their callees, wait
+	// as before, and so does anything started while another method of the
+	// same context is stopped
+	context->resumable = !context->ir_frame_count;
+	if(context->resumable)
+		context->wait.type = 0;
+
+	int status = acpi_exec_method(state, method_return);
+	context->resumable = 0;
+
+	// the OS may call other methods before it resumes this one
+	if(status == ACPI_WOULD_BLOCK)
+		acpi_swap_call();
+
+	return status;
+}
+
+// acpi_resume_method(): Continues the stopped method of the context, once its wait is over
+// Param:	acpi_object_t *method_return - return value of method
+// Return:	int - 0 on success, ACPI_WOULD_BLOCK when it stops again
+
+int acpi_resume_method(acpi_object_t *method_return)
+{
+	acpi_context_t *context = acpi_context();
+	acpi_state_t *state = context->ir_frames[0].state;
+
+	acpi_swap_call();
+
+	int status = acpi_ir_resume(method_return);
+	if(status == ACPI_WOULD_BLOCK)
+	{
+		acpi_swap_call();
+		return status;
+	}
+
+	acpi_arena_leave(state, method_return);
+
+	if(!context->arena_depth && context->mutexes)
+		acpi_release_mutexes();
+
+	return status;
+}
+
+// acpi_swap_call(): Sets aside the call of a method that stopped, or brings it back to resume it
+// Param:	Nothing
+// Return:	Nothing
+
+void acpi_swap_call()
+{
+	acpi_context_t *context = acpi_context();
+	acpi_call_t call;
+
+	// the calls the OS makes meanwhile start out with nothing held, the
+	// budget of their own and the other arena, so that their results are
+	// moved out of it and their mutexes released as they finish
+	call.arena = context->arena;
+	call.arena_top = context->arena_top;
+	call.arena_depth = context->arena_depth;
+	call.sync_level = context->sync_level;
+	call.mutexes = context->mutexes;
+#ifdef ACPI_BUDGET
+	call.budget = context->budget;
+	call.opcodes_left = context->opcodes_left;
+	call.deadline = context->deadline;
+	call.branches = context->branches;
+#endif
+
+	context->arena = context->stopped.arena;
+	context->arena_top = context->stopped.arena_top;
+	context->arena_depth = context->stopped.arena_depth;
+	context->sync_level = context->stopped.sync_level;
+	context->mutexes = context->stopped.mutexes;
+#ifdef ACPI_BUDGET
+	context->budget = context->stopped.budget;
+	context->opcodes_left = context->stopped.opcodes_left;
+	context->deadline = context->stopped.deadline;
+	context->branches = context->stopped.branches;
+#endif
+
+	context->stopped = call;
+}
+
+#ifdef ACPI_BUDGET
+
+// acpi_budget_start(): Sets up the budget of a method the OS calls
+// Param:	acpi_handle_t *method - the method
+// Return:	Nothing
+
+void acpi_budget_start(acpi_handle_t *method)
+{
+	acpi_context_t *context = acpi_context();
+
+	if(method->method_budget)
+		context->budget = method->method_budget;
+	else
+		context->budget = &acpi_budget;
+
+	if(context->budget->opcodes)
+		context->opcodes_left = context->budget->opcodes;
+	else
+		context->opcodes_left = (uint64_t)-1;
+
+	if(context->budget->time)
+		context->deadline = acpi_timer() + context->budget->time;
+	else
+		context->deadline = 0;
+
+	context->branches = 0;
+}
+
+// acpi_budget_branch(): Counts a loop iteration against the budget of the running call
+// Param:	uint64_t opcodes - instructions of the iteration not counted already, for aml2c's C
+// Return:	int - 1 when the call is aborted
+
+int acpi_budget_branch(uint64_t opcodes)
+{
+	acpi_context_t *context = acpi_context();
+	acpi_budget_t *budget = context->budget;
+
+	if(context->opcodes_left > opcodes)
+		context->opcodes_left -= opcodes;
+	else
+		context->opcodes_left = 0;
+
+	context->branches++;
+
+	// reading the clock isn't free, so not every iteration does
+	if(context->deadline && !(context->branches % ACPI_BUDGET_CLOCK) && acpi_timer() >= context->deadline)
+		context->opcodes_left = 0;
+
+	if(budget->yield_interval && budget->yield && !(context->branches % budget->yield_interval))
+		budget->yield();
+
+	return !context->opcodes_left;
+}
+
+#endif
+
 // acpi_exec(): Internal function, executes actual AML opcodes
 // Param:	uint8_t *method - pointer to method opcodes
 // Param:	size_t size - size of method of bytes
 // Param:	acpi_state_t *state - machine state
 // Param:	acpi_object_t *method_return - return value of method
-// Return:	int - 0 on success
+// Return:	int - 0 on success, ACPI_ABORTED
 
 int acpi_exec(uint8_t *method, size_t size, acpi_state_t *state, acpi_object_t *method_return)
 {
@@ -114,70 +343,72 @@ int acpi_exec(uint8_t *method, size_t size, acpi_state_t *state, acpi_object_t *
 		return 0;
 	}
 
-	acpi_strcpy(acpins_path, state->name);
+	acpi_context_t *context = acpi_context();
+	acpi_strcpy(context->path, state->name);
+	context->scope = state->scope;
 
 	size_t i = 0;
-	acpi_object_t invoke_return;
-	state->status = 0;
-	size_t pkgsize, condition_size;
+	acpi_exec_handler_t handler;
+	acpi_block_t *block;
+	acpi_object_t predicate;
+	size_t pkgsize, block_size, loop;
+	state->block_level = 0;
 
-	while(i <= size)
+	while(1)
 	{
-		/* While() loops */
-		if((state->status & ACPI_STATUS_WHILE) == 0 && i >= size)
-			break;
-
-		if((state->status & ACPI_STATUS_WHILE) != 0 && i >= state->loop_end)
-			i = state->loop_start;
+#ifdef ACPI_BUDGET
+		// callers notice the abort when they run their next statement
+		if(!context->opcodes_left)
+		{
+			method_return->type = ACPI_INTEGER;
+			method_return->integer = 0;
+			return ACPI_ABORTED;
+		}
 
-		/* If/Else Conditional */
-		if(!state->condition_level)
-			state->status &= ~ACPI_STATUS_CONDITIONAL;
+		context->opcodes_left--;
+#endif
 
-		if((state->status & ACPI_STATUS_CONDITIONAL) != 0 && i >= state->condition[state->condition_level].end)
+		/* End of an If, Else or While */
+		if(state->block_level && i >= state->block[state->block_level - 1].end)
 		{
-			if(method[i] == ELSE_OP)
+			block = &state->block[state->block_level - 1];
+
+			if(block->type == ACPI_BLOCK_WHILE)
+			{
+#ifdef ACPI_BUDGET
+				acpi_budget_branch(0);
+#endif
+
+				// evaluate the predicate again
+				i = block->predicate;
+				i += acpi_eval_object(&predicate, state, &method[i]);
+				if(predicate.integer == 0)
+				{
+					i = block->end;
+					state->block_level--;
+				}
+
+				continue;
+			}
+
+			// when the If was taken, skip its Else
+			state->block_level--;
+			if(block->type == ACPI_BLOCK_IF && i < size && method[i] == ELSE_OP)
 			{
 				i++;
-				pkgsize = acpi_parse_pkgsize(&method[i], &condition_size);
-				i += condition_size;
+				acpi_parse_pkgsize(&method[i], &block_size);
+				i += block_size;
 			}
 
-			state->condition_level--;
 			continue;
 		}
 
-		/* Method Invokation? */
-		if(acpi_is_name(method[i]))
-			i += acpi_methodinvoke(&method[i], state, &invoke_return);
-
 		if(i >= size)
-			goto return_zero;
-
-		if(acpi_is_name(method[i]))
-			continue;
+			break;
 
-		/* General opcodes */
+		/* Control flow is handled here, everything else goes through the opcode table */
 		switch(method[i])
 		{
-		case ZERO_OP:
-		case ONE_OP:
-		case ONES_OP:
-		case NOP_OP:
-			i++;
-			break;
-
-		case EXTOP_PREFIX:
-			switch(method[i+1])
-			{
-			case SLEEP_OP:
-				i += acpi_exec_sleep(&method[i], state);
-				break;
-			default:
-				acpi_panic("acpi: undefined opcode in control method %s, sequence %xb %xb %xb %xb\n", state->name, method[i], method[i+1], method[i+2], method[i+3]);
-			}
-			break;
-
 		/* A control method can return literally any object */
 		/* So we need to take this into consideration */
 		case RETURN_OP:
@@ -185,126 +416,61 @@ int acpi_exec(uint8_t *method, size_t size, acpi_state_t *state, acpi_object_t *
 			acpi_eval_object(method_return, state, &method[i]);
 			return 0;
 
-		/* While Loops */
+		/* While Loops and If/Else Conditionals */
 		case WHILE_OP:
-			state->loop_start = i;
+		case IF_OP:
 			i++;
-			state->loop_end = i;
-			state->status |= ACPI_STATUS_WHILE;
-			i += acpi_parse_pkgsize(&method[i], &state->loop_pkgsize);
-			state->loop_end += state->loop_pkgsize;
+			pkgsize = acpi_parse_pkgsize(&method[i], &block_size);
+			block = acpi_exec_push_block(state, (method[i-1] == WHILE_OP) ? ACPI_BLOCK_WHILE : ACPI_BLOCK_IF, i + pkgsize, i + block_size);
+			i += pkgsize;
 
 			// evaluate the predicate
-			state->loop_predicate_size = acpi_eval_object(&state->loop_predicate, state, &method[i]);
-			if(state->loop_predicate.integer == 0)
+			i += acpi_eval_object(&predicate, state, &method[i]);
+			if(predicate.integer == 0)
 			{
-				state->status &= ~ACPI_STATUS_WHILE;
-				i = state->loop_end;
-			} else
-			{
-				i += state->loop_predicate_size;
+				i = block->end;
+				state->block_level--;
 			}
 
 			break;
 
-		/* Continue Looping */
+		/* Continue Looping, the end of the While evaluates the predicate again */
 		case CONTINUE_OP:
-			i = state->loop_start;
+			loop = acpi_exec_loop(state);
+			i = state->block[loop].end;
+			state->block_level = loop + 1;
 			break;
 
 		/* Break Loop */
 		case BREAK_OP:
-			i = state->loop_end;
-			state->status &= ~ACPI_STATUS_WHILE;
-			break;
-
-		/* If/Else Conditional */
-		case IF_OP:
-			i++;
-			state->condition_level++;
-			state->condition[state->condition_level].end = i;
-			i += acpi_parse_pkgsize(&method[i], &state->condition[state->condition_level].pkgsize);
-			state->condition[state->condition_level].end += state->condition[state->condition_level].pkgsize;
-
-			// evaluate the predicate
-			state->condition[state->condition_level].predicate_size = acpi_eval_object(&state->condition[state->condition_level].predicate, state, &method[i]);
-			if(state->condition[state->condition_level].predicate.integer == 0)
-			{
-				i = state->condition[state->condition_level].end;
-				state->condition_level--;
-			} else
-			{
-				state->status |= ACPI_STATUS_CONDITIONAL;
-				i += state->condition[state->condition_level].predicate_size;
-			}
-
+			loop = acpi_exec_loop(state);
+			i = state->block[loop].end;
+			state->block_level = loop;
 			break;
 
+		/* Only reached when the If before it wasn't taken */
 		case ELSE_OP:
 			i++;
-			pkgsize = acpi_parse_pkgsize(&method[i], &condition_size);
+			pkgsize = acpi_parse_pkgsize(&method[i], &block_size);
+			acpi_exec_push_block(state, ACPI_BLOCK_ELSE, 0, i + block_size);
 			i += pkgsize;
 			break;
 
-		/* Most of the type 2 opcodes are implemented in exec2.c */
-		case NAME_OP:
-			i += acpi_exec_name(&method[i], state);
-			break;
-		case BYTEFIELD_OP:
-			i += acpi_exec_bytefield(&method[i], state);
-			break;
-		case WORDFIELD_OP:
-			i += acpi_exec_wordfield(&method[i], state);
-			break;
-		case DWORDFIELD_OP:
-			i += acpi_exec_dwordfield(&method[i], state);
-			break;
-		case STORE_OP:
-			i += acpi_exec_store(&method[i], state);
-			break;
-		case ADD_OP:
-			i += acpi_exec_add(&method[i], state);
-			break;
-		case SUBTRACT_OP:
-			i += acpi_exec_subtract(&method[i], state);
-			break;
-		case INCREMENT_OP:
-			i += acpi_exec_increment(&method[i], state);
-			break;
-		case DECREMENT_OP:
-			i += acpi_exec_decrement(&method[i], state);
-			break;
-		case AND_OP:
-			i += acpi_exec_and(&method[i], state);
-			break;
-		case OR_OP:
-			i += acpi_exec_or(&method[i], state);
-			break;
-		case NOT_OP:
-			i += acpi_exec_not(&method[i], state);
-			break;
-		case XOR_OP:
-			i += acpi_exec_xor(&method[i], state);
-			break;
-		case SHR_OP:
-			i += acpi_exec_shr(&method[i], state);
-			break;
-		case SHL_OP:
-			i += acpi_exec_shl(&method[i], state);
-			break;
-		case MULTIPLY_OP:
-			i += acpi_exec_multiply(&method[i], state);
-			break;
-		case DIVIDE_OP:
-			i += acpi_exec_divide(&method[i], state);
-			break;
-
 		default:
-			acpi_panic("acpi: undefined opcode in control method %s, sequence %xb %xb %xb %xb\n", state->name, method[i], method[i+1], method[i+2], method[i+3]);
+			if(method[i] == EXTOP_PREFIX)
+				handler = acpi_extopcodes[method[i+1]].exec;
+			else
+				handler = acpi_opcodes[method[i]].exec;
+
+			if(!handler)
+			{
+				acpi_panic("acpi: undefined opcode in control method %s, sequence %xb %xb %xb %xb\n", state->name, method[i], method[i+1], method[i+2], method[i+3]);
+			}
+
+			i += handler(&method[i], state);
 		}
 	}
 
-return_zero:
 	// when it returns nothing, assume Return (0)
 	method_return->type = ACPI_INTEGER;
 	method_return->integer = 0;
@@ -320,26 +486,31 @@ return_zero:
 size_t acpi_methodinvoke(void *data, acpi_state_t *old_state, acpi_object_t *method_return)
 {
 	uint8_t *methodinvokation = (uint8_t*)data;
+	acpi_context_t *context = acpi_context();
 
 	// save the state of the currently executing method
 	char path_save[ACPI_MAX_NAME];
-	acpi_strcpy(path_save, acpins_path);
+	acpi_strcpy(path_save, context->path);
+	size_t scope_save = context->scope;
 
 	size_t return_size = 0;
 
 	// determine the name of the method
-	acpi_state_t *state = acpi_malloc(sizeof(acpi_state_t));
-	size_t name_size = acpins_resolve_path(state->name, methodinvokation);
-	return_size += name_size;
-	methodinvokation += name_size;
-
+	size_t name_size;
 	acpi_handle_t *method;
-	method = acpi_exec_resolve(state->name);
+	method = acpi_exec_resolve_name(methodinvokation, &name_size);
 	if(!method)
 	{
-		acpi_panic("acpi: undefined MethodInvokation %s\n", state->name);
+		char name[ACPI_MAX_NAME];
+		acpins_resolve_path(name, methodinvokation);
+		acpi_panic("acpi: undefined MethodInvokation %s\n", name);
 	}
 
+	return_size += name_size;
+	methodinvokation += name_size;
+
+	acpi_state_t *state = acpi_push_state(method->path);
+
 	uint8_t argc = method->method_flags & METHOD_ARGC_MASK;
 	uint8_t current_argc = 0;
 	size_t arg_size;
@@ -360,10 +531,143 @@ size_t acpi_methodinvoke(void *data, acpi_state_t *old_state, acpi_object_t *met
 	acpi_exec_method(state, method_return);
 
 	// restore state
-	acpi_strcpy(acpins_path, path_save);
+	acpi_pop_state(state);
+	acpi_strcpy(context->path, path_save);
+	context->scope = scope_save;
 	return return_size;
 }
 
+// acpi_create_context(): Creates the execution context of a thread
+// Param:	Nothing
+// Return:	acpi_context_t * - context, for the OS to return from acpi_get_context()
+
+acpi_context_t *acpi_create_context()
+{
+	// everything else is allocated on first use
+	acpi_context_t *context = acpi_calloc(sizeof(acpi_context_t), 1);
+	context->path[0] = ROOT_CHAR;
+	context->scope = ACPI_NO_SCOPE;
+	return context;
+}
+
+// acpi_push_state(): Takes a method state from the frame pool
+// Param:	char *name - method name
+// Return:	acpi_state_t * - method state, return it with acpi_pop_state()
+
+acpi_state_t *acpi_push_state(char *name)
+{
+	acpi_context_t *context = acpi_context();
+	acpi_state_t *state;
+
+	// method states are taken and returned in LIFO order, like the calls
+	if(!context->state_pool)
+		context->state_pool = acpi_calloc(sizeof(acpi_state_t), ACPI_MAX_FRAMES);
+
+	if(context->state_count < ACPI_MAX_FRAMES)
+	{
+		state = &context->state_pool[context->state_count];
+		context->state_count++;
+	} else
+	{
+		state = acpi_calloc(sizeof(acpi_state_t), 1);
+	}
+
+	// acpi_pop_state() leaves the arguments and locals empty, the caller
+	// fills in the arguments, and the rest of the state is only looked at
+	// after acpi_exec() sets it up; until the method is known to use fewer,
+	// any slot may end up holding an object
+	acpi_strcpy(state->name, name);
+	state->arg_count = 7;
+	state->local_count = 8;
+	state->scope = ACPI_NO_SCOPE;
+	return state;
+}
+
+// acpi_pop_state(): Gives a method state back to the frame pool
+// Param:	acpi_state_t *state - state from acpi_push_state()
+// Return:	Nothing
+
+void acpi_pop_state(acpi_state_t *state)
+{
+	acpi_context_t *context = acpi_context();
+	size_t i;
+
+	// the slots past these were never written, so they are still empty
+	for(i = 0; i < state->arg_count; i++)
+		acpi_free_object(&state->arg[i]);
+	for(i = 0; i < state->local_count; i++)
+		acpi_free_object(&state->local[i]);
+
+	if(state >= context->state_pool && state < &context->state_pool[ACPI_MAX_FRAMES])
+		context->state_count--;
+	else
+		acpi_free(state);
+}
+
+// acpi_exec_push_block(): Enters an If, Else or While block
+// Param:	acpi_state_t *state - AML VM state
+// Param:	int type - ACPI_BLOCK_*
+// Param:	size_t predicate - for While, offset of the predicate
+// Param:	size_t end - offset of the first byte after the block
+// Return:	acpi_block_t * - the new block
+
+acpi_block_t *acpi_exec_push_block(acpi_state_t *state, int type, size_t predicate, size_t end)
+{
+	if(state->block_level >= ACPI_MAX_BLOCKS)
+	{
+		acpi_panic("acpi: control method %s nests more than %d blocks\n", state->name, ACPI_MAX_BLOCKS);
+	}
+
+	acpi_block_t *block = &state->block[state->block_level];
+	block->type = type;
+	block->predicate = predicate;
+	block->end = end;
+
+	state->block_level++;
+	return block;
+}
+
+// acpi_exec_loop(): Finds the innermost While, for Break and Continue
+// Param:	acpi_state_t *state - AML VM state
+// Return:	size_t - index of the While in the block stack
+
+size_t acpi_exec_loop(acpi_state_t *state)
+{
+	int level = state->block_level;
+	while(level)
+	{
+		level--;
+		if(state->block[level].type == ACPI_BLOCK_WHILE)
+			return level;
+	}
+
+	acpi_panic("acpi: Break or Continue outside of While in control method %s\n", state->name);
+}
+
+// acpi_exec_invoke(): Executes a MethodInvokation as a statement
+// Param:	void *data - pointer to MethodInvokation
+// Param:	acpi_state_t *state - AML VM state
+// Return:	size_t - size in bytes for skipping
+
+size_t acpi_exec_invoke(void *data, acpi_state_t *state)
+{
+	acpi_object_t invoke_return;
+	size_t size = acpi_methodinvoke(data, state, &invoke_return);
+
+	acpi_free_object(&invoke_return);
+	return size;
+}
+
+// acpi_exec_nop(): Executes a Noop, or a constant used as a statement
+// Param:	void *data - opcode data
+// Param:	acpi_state_t *state - AML VM state
+// Return:	size_t - size in bytes for skipping
+
+size_t acpi_exec_nop(void *data, acpi_state_t *state)
+{
+	return 1;
+}
+
 // acpi_exec_sleep(): Executes a Sleep() opcode
 // Param:	void *data - opcode data
 // Param:	acpi_state_t *state - AML VM state
@@ -378,9 +682,6 @@ size_t acpi_exec_sleep(void *data, acpi_state_t *state)
 	acpi_object_t time;
 	return_size += acpi_eval_object(&time, state, &opcode[0]);
 
-	if(time.integer == 0)
-		time.integer = 1;
-
 	acpi_sleep(time.integer);
 
 	return return_size;
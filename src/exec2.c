@@ -54,14 +54,377 @@ resolve_alias:
 	return object;
 }
 
+// acpi_exec_resolve_name(): Resolves a NameString in the AML, through the name cache
+// Param:	uint8_t *aml - NameString
+// Param:	size_t *size - destination to store the size of the NameString
+// Return:	acpi_handle_t * - pointer to namespace object, NULL on error
+
+acpi_handle_t *acpi_exec_resolve_name(uint8_t *aml, size_t *size)
+{
+	// the same AML always resolves to the same object from the same scope,
+	// until objects are added to the namespace; the scope is compared by
+	// the handle of the method it names, so a hit costs no string compare
+	acpi_context_t *context = acpi_context();
+	size_t slot = (((size_t)aml >> 4) ^ (size_t)aml) & (ACPI_NAME_CACHE_SIZE - 1);
+
+	if(!context->name_cache)
+		context->name_cache = acpi_calloc(sizeof(acpi_name_cache_t), ACPI_NAME_CACHE_SIZE);
+
+	acpi_name_cache_t *cache = &context->name_cache[slot];
+
+	if(cache->aml == aml && cache->scope == context->scope && cache->generation == acpi_namespace_generation)
+	{
+		size[0] = cache->size;
+		return ACPI_HANDLE(cache->handle);
+	}
+
+	char name[ACPI_MAX_NAME];
+	size[0] = acpins_resolve_path(name, aml);
+
+	acpi_handle_t *handle = acpi_exec_resolve(name);
+	if(!handle)
+		return NULL;
+
+	if(context->scope == ACPI_NO_SCOPE)
+		return handle;
+
+	cache->aml = aml;
+	cache->scope = context->scope;
+	cache->generation = acpi_namespace_generation;
+	cache->handle = handle->index;
+	cache->size = size[0];
+	return handle;
+}
+
+// Reference-counted data sits right after its header
+// The header is 16 bytes so that Package() entries stay aligned
+typedef struct acpi_counted_t
+{
+	uint32_t refcount;
+	uint32_t origin;		// ACPI_COUNTED_*
+	uint64_t size;			// in bytes, without the header
+} acpi_counted_t;
+
+#define ACPI_COUNTED_HEAP		0
+#define ACPI_COUNTED_POOL		1	// small enough for a slot of the pool
+#define ACPI_COUNTED_ARENA		2	// taken back when the arena is reset
+
+#define ACPI_COUNTED(data)		((acpi_counted_t*)((uint8_t*)(data) - sizeof(acpi_counted_t)))
+#define ACPI_ARENA_BYTES(size)		((sizeof(acpi_counted_t) + (size) + 15) & ~(size_t)15)
+
+// Temporaries of a top-level method call are bump-allocated from the arena
+// of the calling thread's context, so only the pool and the reference
+// counts are shared between threads
+#ifdef ACPI_THREADS
+#define ACPI_REFERENCE(counted)		__atomic_add_fetch(&(counted)->refcount, 1, __ATOMIC_RELAXED)
+#define ACPI_UNREFERENCE(counted)	__atomic_sub_fetch(&(counted)->refcount, 1, __ATOMIC_ACQ_REL)
+#define ACPI_REFERENCES(counted)	__atomic_load_n(&(counted)->refcount, __ATOMIC_ACQUIRE)
+#else
+#define ACPI_REFERENCE(counted)		(++(counted)->refcount)
+#define ACPI_UNREFERENCE(counted)	(--(counted)->refcount)
+#define ACPI_REFERENCES(counted)	((counted)->refcount)
+#endif
+
+// Small data that outlives control methods comes from a pool of fixed-size
+// slots, _PRT and _PSS are made of hundreds of small packages
+#define ACPI_POOL_SLOT			(sizeof(acpi_counted_t) + ACPI_POOL_ENTRIES * sizeof(acpi_object_t))
+#define ACPI_POOL_CHUNK			64	// slots allocated at once
+
+void *acpi_pool_free = NULL;		// free slots, linked through their first bytes
+acpi_lock_t acpi_pool_lock;
+
+void *acpi_alloc_heap(size_t);
+
+// acpi_alloc_counted(): Allocates reference-counted data for an object
+// Param:	size_t size - size in bytes
+// Return:	void * - zeroed data with one reference
+
+void *acpi_alloc_counted(size_t size)
+{
+	acpi_context_t *context = acpi_context();
+	acpi_counted_t *counted;
+
+	// outside of control methods, or when the arena is full, use the heap
+	if(!context->arena_depth || context->arena_top + ACPI_ARENA_BYTES(size) > ACPI_ARENA_SIZE)
+		return acpi_alloc_heap(size);
+
+	counted = (acpi_counted_t*)&context->arena[context->arena_top];
+	context->arena_top += ACPI_ARENA_BYTES(size);
+
+	acpi_memset(counted, 0, ACPI_ARENA_BYTES(size));
+	counted->refcount = 1;
+	counted->origin = ACPI_COUNTED_ARENA;
+	counted->size = size;
+	return counted + 1;
+}
+
+// acpi_alloc_heap(): Allocates reference-counted data that outlives control methods
+// Param:	size_t size - size in bytes
+// Return:	void * - zeroed data with one reference
+
+void *acpi_alloc_heap(size_t size)
+{
+	acpi_counted_t *counted;
+	uint8_t *chunk;
+	size_t i;
+
+	if(size > ACPI_POOL_ENTRIES * sizeof(acpi_object_t))
+	{
+		counted = acpi_calloc(1, sizeof(acpi_counted_t) + size);
+		counted->refcount = 1;
+		counted->size = size;
+		return counted + 1;
+	}
+
+	ACPI_LOCK(&acpi_pool_lock);
+	if(!acpi_pool_free)
+	{
+		// slots are never given back to the OS, they are reused instead
+		chunk = acpi_malloc(ACPI_POOL_SLOT * ACPI_POOL_CHUNK);
+		for(i = 0; i < ACPI_POOL_CHUNK; i++)
+		{
+			*(void**)&chunk[i * ACPI_POOL_SLOT] = acpi_pool_free;
+			acpi_pool_free = &chunk[i * ACPI_POOL_SLOT];
+		}
+	}
+
+	counted = acpi_pool_free;
+	acpi_pool_free = *(void**)counted;
+	ACPI_UNLOCK(&acpi_pool_lock);
+
+	acpi_memset(counted, 0, ACPI_POOL_SLOT);
+	counted->refcount = 1;
+	counted->origin = ACPI_COUNTED_POOL;
+	counted->size = size;
+	return counted + 1;
+}
+
+// acpi_arena_enter(): Starts using the arena for a method call
+// Param:	Nothing
+// Return:	Nothing
+
+void acpi_arena_enter()
+{
+	acpi_context_t *context = acpi_context();
+
+	if(!context->arena)
+		context->arena = acpi_malloc(ACPI_ARENA_SIZE);
+
+	context->arena_depth++;
+}
+
+// acpi_arena_leave(): Ends a method call, and resets the arena after a top-level one
+// Param:	acpi_state_t *state - state of the method
+// Param:	acpi_object_t *result - return value of the method
+// Return:	Nothing
+
+void acpi_arena_leave(acpi_state_t *state, acpi_object_t *result)
+{
+	acpi_context_t *context = acpi_context();
+	int i;
+
+	context->arena_depth--;
+	if(context->arena_depth)
+		return;
+
+	// everything that's still referenced after the call must move to the heap
+	// locals mean nothing once the method returns, the arguments belong to the caller
+	for(i = 0; i < 8; i++)
+		acpi_free_object(&state->local[i]);
+	for(i = 0; i < 7; i++)
+		acpi_persist_object(&state->arg[i]);
+
+	acpi_persist_object(result);
+	context->arena_top = 0;
+}
+
+// acpi_persist_object(): Moves an object and everything it holds out of the arena
+// Param:	acpi_object_t *object - object
+// Return:	Nothing
+
+void acpi_persist_object(acpi_object_t *object)
+{
+	void *data = acpi_counted_data(object);
+	acpi_object_t moved;
+	void *copy;
+	int i;
+
+	if(!data)
+		return;
+
+	if(object->type == ACPI_PACKAGE)
+	{
+		for(i = 0; i < object->package_size; i++)
+			acpi_persist_object(&object->package[i]);
+	}
+
+	if(ACPI_COUNTED(data)->origin != ACPI_COUNTED_ARENA)
+		return;
+
+	copy = acpi_alloc_heap(ACPI_COUNTED(data)->size);
+
+	// the entries are on the heap already, the copy just takes references to them
+	if(object->type == ACPI_PACKAGE)
+	{
+		for(i = 0; i < object->package_size; i++)
+			acpi_copy_object(&((acpi_object_t*)copy)[i], &object->package[i]);
+	} else
+		acpi_memcpy(copy, data, ACPI_COUNTED(data)->size);
+
+	moved = object[0];
+	if(object->type == ACPI_PACKAGE)
+		object->package = copy;
+	else if(object->type == ACPI_BUFFER)
+		object->buffer = copy;
+	else
+		object->name = copy;
+
+	// anything else still holding the arena copy keeps it until the reset
+	acpi_free_object(&moved);
+}
+
+// acpi_counted_data(): Returns the reference-counted data of an object
+// Param:	acpi_object_t *object - object
+// Return:	void * - data, NULL if the object doesn't have any
+
+void *acpi_counted_data(acpi_object_t *object)
+{
+	if(object->type == ACPI_BUFFER)
+		return object->buffer;
+	else if(object->type == ACPI_PACKAGE)
+		return object->package;
+	else if(object->type == ACPI_NAME)
+		return object->name;
+	else
+		return NULL;
+}
+
 // acpi_copy_object(): Copies an object
-// Param:	acpi_object_t *destination - destination
+// Param:	acpi_object_t *destination - destination, holds nothing yet
 // Param:	acpi_object_t *source - source
 // Return:	Nothing
 
 void acpi_copy_object(acpi_object_t *destination, acpi_object_t *source)
 {
-	acpi_memcpy(destination, source, sizeof(acpi_object_t));
+	// small enough that this is just two moves
+	destination[0] = source[0];
+
+	// the data is shared until one of them writes to it
+	void *data = acpi_counted_data(destination);
+	if(data)
+		ACPI_REFERENCE(ACPI_COUNTED(data));
+}
+
+// acpi_replace_object(): Copies an object over one that may already hold something
+// Param:	acpi_object_t *destination - destination
+// Param:	acpi_object_t *source - source
+// Return:	Nothing
+
+void acpi_replace_object(acpi_object_t *destination, acpi_object_t *source)
+{
+	// copy first, the source may live inside what the destination holds
+	acpi_object_t copy;
+	acpi_copy_object(&copy, source);
+	acpi_free_object(destination);
+	destination[0] = copy;
+}
+
+// acpi_free_object(): Drops an object's reference to its data
+// Param:	acpi_object_t *object - object, holds nothing afterwards
+// Return:	Nothing
+
+void acpi_free_object(acpi_object_t *object)
+{
+	acpi_context_t *context;
+	void *data = acpi_counted_data(object);
+	acpi_counted_t *counted;
+	int i;
+
+	if(data)
+	{
+		counted = ACPI_COUNTED(data);
+		if(!ACPI_UNREFERENCE(counted))
+		{
+			if(object->type == ACPI_PACKAGE)
+			{
+				for(i = 0; i < object->package_size; i++)
+					acpi_free_object(&object->package[i]);
+			}
+
+			// the arena is only reset after the call, but temporaries are
+			// often freed in reverse order, so give back the last one now
+			if(counted->origin == ACPI_COUNTED_HEAP)
+				acpi_free(counted);
+			else if(counted->origin == ACPI_COUNTED_POOL)
+			{
+				ACPI_LOCK(&acpi_pool_lock);
+				*(void**)counted = acpi_pool_free;
+				acpi_pool_free = counted;
+				ACPI_UNLOCK(&acpi_pool_lock);
+			} else
+			{
+				context = acpi_context();
+				if((uint8_t*)counted + ACPI_ARENA_BYTES(counted->size) == &context->arena[context->arena_top])
+					context->arena_top -= ACPI_ARENA_BYTES(counted->size);
+			}
+		}
+	}
+
+	object->type = 0;
+	object->integer = 0;
+}
+
+// acpi_write_entry(): Writes to an entry of a Package()
+// Param:	acpi_object_t *package - package, not shared with anything
+// Param:	size_t index - index of the entry
+// Param:	acpi_object_t *source - object to write
+// Return:	Nothing
+
+void acpi_write_entry(acpi_object_t *package, size_t index, acpi_object_t *source)
+{
+	acpi_replace_object(&package->package[index], source);
+
+	// a package on the heap can outlive the arena, so its entries can't be in it
+	if(ACPI_COUNTED(package->package)->origin != ACPI_COUNTED_ARENA)
+		acpi_persist_object(&package->package[index]);
+}
+
+// acpi_unshare_object(): Makes an object's data private before writing to it
+// Param:	acpi_object_t *object - object
+// Return:	Nothing
+
+void acpi_unshare_object(acpi_object_t *object)
+{
+	void *data = acpi_counted_data(object);
+	acpi_object_t shared = object[0];
+	void *copy;
+	int i;
+
+	if(!data || ACPI_REFERENCES(ACPI_COUNTED(data)) == 1)
+		return;
+
+	// the copy lives where the original did, namespace objects stay on the heap
+	if(ACPI_COUNTED(data)->origin == ACPI_COUNTED_ARENA)
+		copy = acpi_alloc_counted(ACPI_COUNTED(data)->size);
+	else
+		copy = acpi_alloc_heap(ACPI_COUNTED(data)->size);
+
+	if(object->type == ACPI_PACKAGE)
+	{
+		// the entries themselves stay shared, until they're written to
+		for(i = 0; i < object->package_size; i++)
+			acpi_copy_object(&((acpi_object_t*)copy)[i], &object->package[i]);
+
+		object->package = copy;
+	} else
+	{
+		// Name References are never written to, so this is a Buffer
+		acpi_memcpy(copy, data, ACPI_COUNTED(data)->size);
+		object->buffer = copy;
+	}
+
+	// the other references may have gone away in the meantime
+	acpi_free_object(&shared);
 }
 
 // acpi_write_object(): Writes to an object
@@ -137,7 +500,7 @@ size_t acpi_write_object(void *data, acpi_object_t *source, acpi_state_t *state)
 			break;
 		}
 
-		acpi_copy_object(dest_reg, source);
+		acpi_replace_object(dest_reg, source);
 		return 1;
 	}
 
@@ -163,15 +526,15 @@ size_t acpi_write_object(void *data, acpi_object_t *source, acpi_state_t *state)
 	{
 		char name[ACPI_MAX_NAME];
 		size_t name_size;
-		name_size = acpins_resolve_path(name, dest);
-		acpi_handle_t *handle = acpi_exec_resolve(name);
+		acpi_handle_t *handle = acpi_exec_resolve_name(dest, &name_size);
 		if(!handle)
 		{
+			acpins_resolve_path(name, dest);
 			acpi_panic("acpi: undefined reference %s\n", name);
 		}
 
 		if(handle->type == ACPI_NAMESPACE_NAME)
-			acpi_copy_object(&handle->object, source);
+			acpins_write_name(handle, source);
 		else if(handle->type == ACPI_NAMESPACE_FIELD || handle->type == ACPI_NAMESPACE_INDEXFIELD)
 			acpi_write_opregion(handle, source);
 		else if(handle->type == ACPI_NAMESPACE_BUFFER_FIELD)
@@ -187,30 +550,81 @@ size_t acpi_write_object(void *data, acpi_object_t *source, acpi_state_t *state)
 		return_size = 1;
 		dest++;
 
-		// the first object should be a package
-		acpi_object_t object, index;
+		// Index() writes to the package or buffer where it is stored,
+		// which has to stop sharing its data with any copies first
+		acpi_object_t index;
+		acpi_object_t *object;
+		uint8_t *holder = dest;
 
 		size_t object_size;
-		object_size = acpi_eval_object(&object, state, &dest[0]);
+		acpi_exec_holder(holder, state, &object_size);
 		return_size += object_size;
 		dest += object_size;
 
 		object_size = acpi_eval_object(&index, state, &dest[0]);
 		return_size += object_size;
+		dest += object_size;
 
-		if(object.type == ACPI_PACKAGE)
+		if(dest[0] != ZERO_OP)
 		{
-			acpi_copy_object(&object.package[index.integer], source);
-			return return_size;
-		} else
+			acpi_panic("acpi: Index() with a target is not supported as a destination.\n");
+		}
+
+		return_size++;
+
+		// evaluating the index may have moved the namespace
+		object = acpi_exec_holder(holder, state, &object_size);
+
+		// Names are shared with other threads, Locals and Args aren't
+		if(acpi_is_name(holder[0]))
+			ACPI_LOCK(&acpi_namespace_lock);
+
+		acpi_unshare_object(object);
+
+		if(object->type == ACPI_PACKAGE && index.integer < object->package_size)
+			acpi_write_entry(object, index.integer, source);
+		else if(object->type == ACPI_BUFFER && index.integer < object->buffer_size)
+			((uint8_t*)object->buffer)[index.integer] = (uint8_t)source->integer;
+		else
 		{
-			acpi_panic("acpi: cannot write Index() to non-package object: %d\n", object.type);
+			acpi_panic("acpi: cannot write Index() %d to object type %d\n", (int)index.integer, object->type);
 		}
+
+		if(acpi_is_name(holder[0]))
+			ACPI_UNLOCK(&acpi_namespace_lock);
+
+		return return_size;
 	}
 
 	acpi_panic("acpi: undefined opcode, sequence %xb %xb %xb %xb\n", dest[0], dest[1], dest[2], dest[3]);
 }
 
+// acpi_exec_holder(): Finds the object held by a LocalX, ArgX or Name()
+// Param:	uint8_t *data - LocalX, ArgX or NameString
+// Param:	acpi_state_t *state - state of the AML VM
+// Param:	size_t *size - destination to store the size in bytes
+// Return:	acpi_object_t * - the object itself, not a copy
+
+acpi_object_t *acpi_exec_holder(uint8_t *data, acpi_state_t *state, size_t *size)
+{
+	if(data[0] >= LOCAL0_OP && data[0] <= LOCAL7_OP)
+	{
+		size[0] = 1;
+		return &state->local[data[0] - LOCAL0_OP];
+	} else if(data[0] >= ARG0_OP && data[0] <= ARG6_OP)
+	{
+		size[0] = 1;
+		return &state->arg[data[0] - ARG0_OP];
+	} else if(acpi_is_name(data[0]))
+	{
+		acpi_handle_t *handle = acpi_exec_resolve_name(data, size);
+		if(handle && handle->type == ACPI_NAMESPACE_NAME)
+			return acpins_load_object(handle);
+	}
+
+	acpi_panic("acpi: Index() destination must be a LocalX, ArgX or Name(), sequence %xb %xb %xb %xb\n", data[0], data[1], data[2], data[3]);
+}
+
 // acpi_write_buffer(): Writes to a Buffer Field
 // Param:	acpi_handle_t *handle - handle of buffer field
 // Param:	acpi_object_t *source - object to write
@@ -226,6 +640,10 @@ void acpi_write_buffer(acpi_handle_t *handle, acpi_object_t *source)
 
 	uint64_t value = source->integer;
 
+	// copies of the buffer keep the old contents
+	ACPI_LOCK(&acpi_namespace_lock);
+	acpi_unshare_object(&buffer_handle->object);
+
 	uint64_t offset = handle->buffer_offset / 8;
 	uint64_t bitshift = handle->buffer_offset % 8;
 
@@ -258,6 +676,8 @@ void acpi_write_buffer(acpi_handle_t *handle, acpi_object_t *source)
 		qword[0] &= mask;
 		qword[0] |= value;
 	}
+
+	ACPI_UNLOCK(&acpi_namespace_lock);
 }
 
 // acpi_exec_store(): Executes a Store() opcode
@@ -282,6 +702,7 @@ size_t acpi_exec_store(void *data, acpi_state_t *state)
 	// now work on the destination
 	// destination may be name or variable
 	dest_size = acpi_write_object(&store[0], &source, state);
+	acpi_free_object(&source);
 
 	return_size += dest_size;
 	return return_size;
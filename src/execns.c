@@ -22,24 +22,37 @@ size_t acpi_exec_name(void *data, acpi_state_t *state)
 	char path[ACPI_MAX_NAME];
 	size_t size = acpins_resolve_path(path, name);
 
+	return_size += size;
+	name += size;
+
+	// evaluate first, it can add objects and move the namespace
+	acpi_object_t object;
+	size = acpi_eval_object(&object, state, name);
+	return_size += size;
+
+	ACPI_LOCK(&acpi_namespace_lock);
+
 	acpi_handle_t *handle;
 	handle = acpins_resolve(path);
 	if(!handle)
 	{
 		// create it if it doesn't already exist
-		acpi_namespace[acpi_namespace_entries].type = ACPI_NAMESPACE_NAME;
-		acpi_strcpy(acpi_namespace[acpi_namespace_entries].path, path);
-		handle = &acpi_namespace[acpi_namespace_entries];
-
+		ACPI_HANDLE(acpi_namespace_entries)->type = ACPI_NAMESPACE_NAME;
+		acpi_strcpy(ACPI_HANDLE(acpi_namespace_entries)->path, path);
 		acpins_increment_namespace();
-	}
 
-	return_size += size;
-	name += size;
+		// the namespace may have moved
+		handle = ACPI_HANDLE(acpi_namespace_entries - 1);
+	}
 
-	size = acpi_eval_object(&handle->object, state, name);
-	return_size += size;
+	// the object is moved, not copied
+	// a package that was never decoded has nothing to free
+	handle->pointer = NULL;
+	acpi_free_object(&handle->object);
+	handle->object = object;
+	acpi_persist_object(&handle->object);
 
+	ACPI_UNLOCK(&acpi_namespace_lock);
 	return return_size;
 }
 
@@ -66,12 +79,15 @@ size_t acpi_exec_buffer(acpi_object_t *destination, acpi_state_t *state, void *d
 
 	destination->type = ACPI_BUFFER;
 	destination->buffer_size = buffer_size.integer;
-	destination->buffer = acpi_malloc(destination->buffer_size);
+	destination->buffer = acpi_alloc_counted(destination->buffer_size);
 
-	size -= ((size_t)buffer - (size_t)data);
+	// the initializer can be shorter than the buffer, the rest is zero
+	size -= ((size_t)buffer - (size_t)data - 1);
+	if(size > destination->buffer_size)
+		size = destination->buffer_size;
 
 	if(size)
-		acpi_memcpy(destination->buffer, buffer, destination->buffer_size);
+		acpi_memcpy(destination->buffer, buffer, size);
 
 	return return_size;
 }
@@ -83,7 +99,10 @@ size_t acpi_exec_buffer(acpi_object_t *destination, acpi_state_t *state, void *d
 
 size_t acpi_exec_bytefield(void *data, acpi_state_t *state)
 {
-	return acpins_create_bytefield(data);	// dirty af solution but good enough for now
+	ACPI_LOCK(&acpi_namespace_lock);
+	size_t size = acpins_create_bytefield(data);
+	ACPI_UNLOCK(&acpi_namespace_lock);
+	return size;
 }
 
 
@@ -94,7 +113,10 @@ size_t acpi_exec_bytefield(void *data, acpi_state_t *state)
 
 size_t acpi_exec_wordfield(void *data, acpi_state_t *state)
 {
-	return acpins_create_wordfield(data);	// dirty af solution but good enough for now
+	ACPI_LOCK(&acpi_namespace_lock);
+	size_t size = acpins_create_wordfield(data);
+	ACPI_UNLOCK(&acpi_namespace_lock);
+	return size;
 }
 
 
@@ -105,11 +127,22 @@ size_t acpi_exec_wordfield(void *data, acpi_state_t *state)
 
 size_t acpi_exec_dwordfield(void *data, acpi_state_t *state)
 {
-	return acpins_create_dwordfield(data);	// dirty af solution but good enough for now
+	ACPI_LOCK(&acpi_namespace_lock);
+	size_t size = acpins_create_dwordfield(data);
+	ACPI_UNLOCK(&acpi_namespace_lock);
+	return size;
 }
 
 
+// acpi_exec_qwordfield(): Creates a QwordField object
+// Param:	void *data - data
+// Param:	acpi_state_t *state - AML VM state
+// Return:	size_t - size for skipping
 
-
-
-
+size_t acpi_exec_qwordfield(void *data, acpi_state_t *state)
+{
+	ACPI_LOCK(&acpi_namespace_lock);
+	size_t size = acpins_create_qwordfield(data);
+	ACPI_UNLOCK(&acpi_namespace_lock);
+	return size;
+}
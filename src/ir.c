@@ -0,0 +1,1028 @@
+
+/*
+ * Lux ACPI Implementation
+ * Copyright (C) 2018 by Omar Mohammad
+ */
+
+/* ACPI Control Method IR Execution */
+/* Runs methods that compile.c has translated. Operands live on a small stack
+ * instead of being decoded from AML, and branches jump straight to their
+ * targets. Calls between compiled methods push a frame on a heap-allocated
+ * frame stack rather than recursing in C. */
+
+#include "lai.h"
+
+acpi_ir_frame_t *acpi_ir_push_frame(acpi_ir_t *, acpi_state_t *);
+int acpi_ir_run(size_t, int, acpi_object_t *);
+int acpi_ir_abort(size_t, size_t, acpi_object_t *);
+
+// taken jumps backwards are loop iterations, see acpi_budget_branch()
+#ifdef ACPI_BUDGET
+#define ACPI_IR_BRANCH(op, ip)		do { if((op)->target < (ip)) acpi_budget_branch(0); } while(0)
+#else
+#define ACPI_IR_BRANCH(op, ip)
+#endif
+
+// acpi_ir_resolve(): Resolves the name of an instruction, caching the result in it
+// Param:	acpi_irop_t *op - instruction
+// Return:	acpi_handle_t * - pointer to namespace object, NULL on error
+
+acpi_handle_t *acpi_ir_resolve(acpi_irop_t *op)
+{
+	// names are full paths by now, so nothing but new objects can change them
+#ifdef ACPI_THREADS
+	// the IR is shared, so other threads may be filling in the same cache;
+	// the generation is published last, and only once the index is there
+	if(__atomic_load_n(&op->generation, __ATOMIC_ACQUIRE) == acpi_namespace_generation)
+	{
+		size_t handle = __atomic_load_n(&op->handle, __ATOMIC_RELAXED);
+		return ACPI_HANDLE(handle);
+	}
+#else
+	if(op->generation == acpi_namespace_generation)
+		return ACPI_HANDLE(op->handle);
+#endif
+
+	// acpi_exec_resolve() modifies the path it's given
+	char path[ACPI_MAX_NAME];
+	acpi_strcpy(path, op->name);
+
+	acpi_handle_t *handle = acpi_exec_resolve(path);
+	if(!handle)
+		return NULL;
+
+#ifdef ACPI_THREADS
+	__atomic_store_n(&op->handle, handle->index, __ATOMIC_RELAXED);
+	__atomic_store_n(&op->generation, acpi_namespace_generation, __ATOMIC_RELEASE);
+#else
+	op->handle = handle->index;
+	op->generation = acpi_namespace_generation;
+#endif
+	return handle;
+}
+
+// acpi_ir_mutex(): Resolves the mutex of Acquire() or Release() during IR execution
+// Param:	acpi_irop_t *op - instruction with the full path
+// Return:	acpi_mutex_t * - mutex
+
+acpi_mutex_t *acpi_ir_mutex(acpi_irop_t *op)
+{
+	acpi_handle_t *handle = acpi_ir_resolve(op);
+	if(!handle || handle->type != ACPI_NAMESPACE_MUTEX)
+	{
+		acpi_panic("acpi: %s is not a mutex\n", op->name);
+	}
+
+	return handle->mutex;
+}
+
+// acpi_ir_event(): Resolves the event of Wait(), Signal() or Reset() during IR execution
+// Param:	acpi_irop_t *op - instruction with the full path
+// Return:	acpi_event_t * - event
+
+acpi_event_t *acpi_ir_event(acpi_irop_t *op)
+{
+	acpi_handle_t *handle = acpi_ir_resolve(op);
+	if(!handle || handle->type != ACPI_NAMESPACE_EVENT)
+	{
+		acpi_panic("acpi: %s is not an event\n", op->name);
+	}
+
+	return handle->event;
+}
+
+// acpi_ir_read_name(): Reads a Name() or a Field during IR execution
+// Param:	acpi_object_t *destination - destination
+// Param:	acpi_irop_t *op - instruction with the full path, as built at compile time
+// Return:	Nothing
+
+void acpi_ir_read_name(acpi_object_t *destination, acpi_irop_t *op)
+{
+	acpi_handle_t *handle = acpi_ir_resolve(op);
+	if(!handle)
+	{
+		acpi_panic("acpi: undefined reference %s\n", op->name);
+	}
+
+	if(handle->type == ACPI_NAMESPACE_NAME)
+		acpins_read_name(destination, handle);
+	else if(handle->type == ACPI_NAMESPACE_FIELD || handle->type == ACPI_NAMESPACE_INDEXFIELD)
+		acpi_read_opregion(destination, handle);
+	else
+	{
+		acpi_panic("acpi: undefined behavior when path doesn't resolve into valid data or code.\n");
+	}
+}
+
+// acpi_ir_write_name(): Writes to a Name() or a Field during IR execution
+// Param:	acpi_irop_t *op - instruction with the full path, as built at compile time
+// Param:	acpi_object_t *source - object to write
+// Return:	Nothing
+
+void acpi_ir_write_name(acpi_irop_t *op, acpi_object_t *source)
+{
+	acpi_handle_t *handle = acpi_ir_resolve(op);
+	if(!handle)
+	{
+		acpi_panic("acpi: undefined reference %s\n", op->name);
+	}
+
+	if(handle->type == ACPI_NAMESPACE_NAME)
+		acpins_write_name(handle, source);
+	else if(handle->type == ACPI_NAMESPACE_FIELD || handle->type == ACPI_NAMESPACE_INDEXFIELD)
+		acpi_write_opregion(handle, source);
+	else if(handle->type == ACPI_NAMESPACE_BUFFER_FIELD)
+		acpi_write_buffer(handle, source);
+	else
+	{
+		acpi_panic("acpi: NameSpec destination is not a writeable object.\n");
+	}
+}
+
+// acpi_ir_store_index(): Writes an element of a package or buffer for Store() to Index()
+// Param:	acpi_irop_t *op - instruction, says whether a Local, an Arg or a Name holds it
+// Param:	acpi_state_t *state - machine state
+// Param:	uint64_t index - element to write
+// Param:	acpi_object_t *source - object to write
+// Return:	Nothing
+
+void acpi_ir_store_index(acpi_irop_t *op, acpi_state_t *state, uint64_t index, acpi_object_t *source)
+{
+	acpi_object_t *holder;
+	acpi_handle_t *handle;
+
+	// writes go to the object holding the package or buffer, not a copy
+	if(op->integer == ACPI_IR_LOCAL)
+		holder = &state->local[op->index];
+	else if(op->integer == ACPI_IR_ARG)
+		holder = &state->arg[op->index];
+	else
+	{
+		handle = acpi_ir_resolve(op);
+		if(!handle || handle->type != ACPI_NAMESPACE_NAME)
+		{
+			acpi_panic("acpi: Index() destination %s is not a Name()\n", op->name);
+		}
+
+		holder = acpins_load_object(handle);
+	}
+
+	// Names are shared with other threads, Locals and Args aren't
+	if(op->integer != ACPI_IR_LOCAL && op->integer != ACPI_IR_ARG)
+		ACPI_LOCK(&acpi_namespace_lock);
+
+	acpi_unshare_object(holder);
+
+	if(holder->type == ACPI_PACKAGE && index < holder->package_size)
+		acpi_write_entry(holder, index, source);
+	else if(holder->type == ACPI_BUFFER && index < holder->buffer_size)
+		((uint8_t*)holder->buffer)[index] = (uint8_t)source->integer;
+	else
+	{
+		acpi_panic("acpi: cannot write Index() %d to object type %d\n", (int)index, holder->type);
+	}
+
+	if(op->integer != ACPI_IR_LOCAL && op->integer != ACPI_IR_ARG)
+		ACPI_UNLOCK(&acpi_namespace_lock);
+}
+
+// acpi_ir_index(): Replaces a string, buffer or package with one of its elements
+// Param:	acpi_object_t *object - object, dropped after
+// Param:	uint64_t index - element to read
+// Return:	Nothing
+
+void acpi_ir_index(acpi_object_t *object, uint64_t index)
+{
+	acpi_object_t source = object[0];
+
+	if(source.type == ACPI_STRING && index < acpi_strlen(source.string))
+	{
+		object->type = ACPI_INTEGER;
+		object->integer = (uint64_t)(uint8_t)source.string[index];
+	} else if(source.type == ACPI_BUFFER && index < source.buffer_size)
+	{
+		object->type = ACPI_INTEGER;
+		object->integer = (uint64_t)((uint8_t*)source.buffer)[index];
+	} else if(source.type == ACPI_PACKAGE && index < source.package_size)
+	{
+		acpi_copy_object(object, &source.package[index]);
+	} else
+	{
+		acpi_panic("acpi: cannot read Index() %d from object type %d\n", (int)index, source.type);
+	}
+
+	acpi_free_object(&source);
+}
+
+// acpi_ir_sizeof(): Replaces an object with its size
+// Param:	acpi_object_t *object - object, dropped after
+// Return:	Nothing
+
+void acpi_ir_sizeof(acpi_object_t *object)
+{
+	uint64_t size;
+
+	if(object->type == ACPI_INTEGER)
+		size = 8;	// treat all integers like qwords
+	else if(object->type == ACPI_STRING)
+		size = acpi_strlen(object->string);
+	else if(object->type == ACPI_PACKAGE)
+		size = object->package_size;
+	else if(object->type == ACPI_BUFFER)
+		size = object->buffer_size;
+	else
+	{
+		acpi_panic("acpi: can't perform SizeOf on object type %d\n", object->type);
+	}
+
+	acpi_free_object(object);
+	object->type = ACPI_INTEGER;
+	object->integer = size;
+}
+
+// acpi_ir_define_name(): Creates or redefines a Name() within a method
+// Param:	acpi_irop_t *op - instruction with the full path
+// Param:	acpi_object_t *object - value, moved into the namespace
+// Return:	Nothing
+
+void acpi_ir_define_name(acpi_irop_t *op, acpi_object_t *object)
+{
+	ACPI_LOCK(&acpi_namespace_lock);
+
+	acpi_handle_t *handle = acpins_resolve(op->name);
+	if(!handle)
+	{
+		// create it if it doesn't already exist
+		handle = ACPI_HANDLE(acpi_namespace_entries);
+		handle->type = ACPI_NAMESPACE_NAME;
+		acpi_strcpy(handle->path, op->name);
+		acpins_increment_namespace();
+
+		// the namespace may have moved
+		handle = ACPI_HANDLE(acpi_namespace_entries - 1);
+	}
+
+	// a package that was never decoded has nothing to free
+	handle->pointer = NULL;
+	acpi_free_object(&handle->object);
+	handle->object = object[0];
+	acpi_persist_object(&handle->object);
+
+	ACPI_UNLOCK(&acpi_namespace_lock);
+}
+
+// acpi_ir_create_field(): Runs CreateByteField() and friends from their AML
+// Param:	acpi_irop_t *op - instruction
+// Param:	acpi_state_t *state - machine state
+// Return:	Nothing
+
+void acpi_ir_create_field(acpi_irop_t *op, acpi_state_t *state)
+{
+	if(op->index == BYTEFIELD_OP)
+		acpi_exec_bytefield(op->aml, state);
+	else if(op->index == WORDFIELD_OP)
+		acpi_exec_wordfield(op->aml, state);
+	else if(op->index == DWORDFIELD_OP)
+		acpi_exec_dwordfield(op->aml, state);
+	else
+		acpi_exec_qwordfield(op->aml, state);
+}
+
+// acpi_ir_push_frame(): Pushes a frame onto the IR frame stack
+// Param:	acpi_ir_t *ir - compiled method
+// Param:	acpi_state_t *state - machine state of the method
+// Return:	acpi_ir_frame_t * - new frame, NULL when the mutex of a Serialized method can't be acquired
+
+acpi_ir_frame_t *acpi_ir_push_frame(acpi_ir_t *ir, acpi_state_t *state)
+{
+	acpi_context_t *context = acpi_context();
+	acpi_ir_frame_t *frame;
+
+	// allocated once and never moved, so pointers into them stay valid
+	// even when the AML interpreter calls back into us
+	if(!context->ir_frames)
+	{
+		context->ir_frames = acpi_calloc(sizeof(acpi_ir_frame_t), ACPI_IR_MAX_DEPTH);
+		context->ir_stack = acpi_calloc(sizeof(acpi_object_t), ACPI_IR_MAX_DEPTH * ACPI_IR_MAX_STACK);
+	}
+
+	if(context->ir_frame_count >= ACPI_IR_MAX_DEPTH)
+	{
+		acpi_panic("acpi: control methods nested deeper than %d calls, last %s\n", ACPI_IR_MAX_DEPTH, state->name);
+	}
+
+	acpi_strcpy(context->path, state->name);
+	context->scope = state->scope;
+
+	// held until the frame is popped, which may be after the method stopped
+	// and resumed; without it, the method doesn't run at all
+	if(ir->mutex && acpi_acquire_mutex(ir->mutex, ACPI_FOREVER))
+		return NULL;
+
+	frame = &context->ir_frames[context->ir_frame_count];
+	frame->ir = ir;
+	frame->mutex = ir->mutex;
+	frame->state = state;
+	frame->ip = 0;
+	frame->sp = 0;
+
+	// acpi_pop_state() only frees the slots the method uses
+	state->arg_count = ir->arg_count;
+	state->local_count = ir->local_count;
+
+	if(context->ir_frame_count)
+		frame->base = frame[-1].base + frame[-1].ir->stack_size;
+	else
+		frame->base = 0;
+
+	context->ir_frame_count++;
+	return frame;
+}
+
+// acpi_ir_memo_lookup(): Looks for the cached result of a pure method
+// Param:	acpi_ir_t *ir - compiled method, pure
+// Param:	acpi_state_t *state - state with the arguments
+// Param:	acpi_object_t *result - destination, holds nothing yet
+// Return:	int - 1 if the result was cached
+
+int acpi_ir_memo_lookup(acpi_ir_t *ir, acpi_state_t *state, acpi_object_t *result)
+{
+	size_t i, j;
+
+	if(!ir->memo)
+		return 0;
+
+	// other threads may be replacing entries
+	ACPI_LOCK(&acpi_namespace_lock);
+	for(i = 0; i < ACPI_MEMO_ENTRIES; i++)
+	{
+		if(!ir->memo[i].valid)
+			continue;
+
+		for(j = 0; j < ir->argc; j++)
+		{
+			if(state->arg[j].type != ACPI_INTEGER || state->arg[j].integer != ir->memo[i].arg[j])
+				break;
+		}
+
+		if(j == ir->argc)
+		{
+			acpi_copy_object(result, &ir->memo[i].result);
+			ACPI_UNLOCK(&acpi_namespace_lock);
+			return 1;
+		}
+	}
+
+	ACPI_UNLOCK(&acpi_namespace_lock);
+	return 0;
+}
+
+// acpi_ir_memo_store(): Caches the result of a pure method
+// Param:	acpi_ir_t *ir - compiled method, pure
+// Param:	acpi_state_t *state - state with the arguments
+// Param:	acpi_object_t *result - return value, moved out of the arena if needed
+// Return:	Nothing
+
+void acpi_ir_memo_store(acpi_ir_t *ir, acpi_state_t *state, acpi_object_t *result)
+{
+	acpi_memo_t *memo;
+	size_t i;
+
+	// only Integer arguments make a key
+	for(i = 0; i < ir->argc; i++)
+	{
+		if(state->arg[i].type != ACPI_INTEGER)
+			return;
+	}
+
+	// the cache outlives the call
+	acpi_persist_object(result);
+
+	ACPI_LOCK(&acpi_namespace_lock);
+	if(!ir->memo)
+		ir->memo = acpi_calloc(sizeof(acpi_memo_t), ACPI_MEMO_ENTRIES);
+
+	memo = &ir->memo[ir->memo_next];
+	ir->memo_next = (ir->memo_next + 1) % ACPI_MEMO_ENTRIES;
+
+	acpi_free_object(&memo->result);
+	for(i = 0; i < ir->argc; i++)
+		memo->arg[i] = state->arg[i].integer;
+
+	acpi_copy_object(&memo->result, result);
+	memo->valid = 1;
+	ACPI_UNLOCK(&acpi_namespace_lock);
+}
+
+// acpi_ir_exec(): Executes a compiled control method
+// Param:	acpi_ir_t *ir - compiled method
+// Param:	acpi_state_t *state - machine state
+// Param:	acpi_object_t *method_return - return value of method
+// Return:	int - 0 on success, ACPI_WOULD_BLOCK when it stops, ACPI_ABORTED, -1 as for acpi_exec_method()
+
+int acpi_ir_exec(acpi_ir_t *ir, acpi_state_t *state, acpi_object_t *method_return)
+{
+	acpi_context_t *context = acpi_context();
+
+	// only the method acpi_start_method() runs may stop, not its callees
+	int resumable = context->resumable;
+	context->resumable = 0;
+
+#ifdef ACPI_JIT
+	// hot integer-only methods run as native code
+	if(!acpi_jit_exec(ir, state, method_return))
+		return 0;
+#endif
+
+	size_t entry = context->ir_frame_count;
+	if(!acpi_ir_push_frame(ir, state))
+		return -1;
+
+	return acpi_ir_run(entry, resumable, method_return);
+}
+
+// acpi_ir_resume(): Continues a compiled method that stopped at a blocking instruction
+// Param:	acpi_object_t *method_return - return value of method
+// Return:	int - 0 on success, ACPI_WOULD_BLOCK when it stops again
+
+int acpi_ir_resume(acpi_object_t *method_return)
+{
+	// the frames are where acpi_ir_run() left them
+	return acpi_ir_run(0, 1, method_return);
+}
+
+// acpi_ir_run(): Runs the IR frame stack from its top frame
+// Param:	size_t entry - frames below this belong to callers in C
+// Param:	int resumable - 1 when blocking instructions stop instead of waiting
+// Param:	acpi_object_t *method_return - return value of the frame above entry
+// Return:	int - 0 on success, ACPI_WOULD_BLOCK when it stops, ACPI_ABORTED
+
+int acpi_ir_run(size_t entry, int resumable, acpi_object_t *method_return)
+{
+	// MethodInvokations of compiled methods push a frame instead of recursing,
+	// so this is the only C stack frame no matter how deep the calls go, and
+	// everything needed to continue later is in the frames
+	acpi_context_t *context = acpi_context();
+	acpi_ir_frame_t *frame = &context->ir_frames[context->ir_frame_count - 1];
+	acpi_ir_t *ir = frame->ir;
+	acpi_state_t *state = frame->state;
+	acpi_object_t *stack = &context->ir_stack[frame->base];
+	size_t sp = frame->sp;		// next free slot
+	size_t ip = frame->ip;
+	acpi_irop_t *op;
+
+	acpi_strcpy(context->path, state->name);
+	context->scope = state->scope;
+
+	acpi_object_t object, index;
+	acpi_state_t *invoke_state;
+	acpi_handle_t *handle;
+	acpi_ir_t *invoke_ir;
+	acpi_mutex_t *mutex;
+	acpi_event_t *event;
+	size_t i;
+	int status;
+
+	while(1)
+	{
+#ifdef ACPI_BUDGET
+		if(!context->opcodes_left)
+			return acpi_ir_abort(entry, sp, method_return);
+
+		context->opcodes_left--;
+#endif
+
+		if(ip >= ir->count)
+		{
+			// when it returns nothing, assume Return (0)
+			stack[sp].type = ACPI_INTEGER;
+			stack[sp].integer = 0;
+			sp++;
+			op = NULL;
+		} else
+		{
+			op = &ir->code[ip];
+			ip++;
+		}
+
+		if(!op || op->opcode == ACPI_IR_RETURN)
+		{
+			sp--;
+			context->ir_frame_count--;
+
+			if(frame->mutex)
+				acpi_release_method_mutex(frame->mutex);
+
+			if(ir->pure)
+				acpi_ir_memo_store(ir, state, &stack[sp]);
+
+			// the result is moved rather than copied, it's off the stack now
+			if(context->ir_frame_count == entry)
+			{
+				method_return[0] = stack[sp];
+				return 0;
+			}
+
+			// hand the result to the caller, in place of the arguments it pushed
+			context->ir_stack[frame[-1].base + frame[-1].sp] = stack[sp];
+			acpi_pop_state(state);
+
+			frame--;
+			ir = frame->ir;
+			state = frame->state;
+			ip = frame->ip;
+			sp = frame->sp + 1;
+			stack = &context->ir_stack[frame->base];
+			acpi_strcpy(context->path, state->name);
+			context->scope = state->scope;
+			continue;
+		}
+
+		switch(op->opcode)
+		{
+		case ACPI_IR_INTEGER:
+			stack[sp].type = ACPI_INTEGER;
+			stack[sp].integer = op->integer;
+			sp++;
+			break;
+
+		case ACPI_IR_STRING:
+			stack[sp].type = ACPI_STRING;
+			stack[sp].string = (char*)op->aml;
+			sp++;
+			break;
+
+		case ACPI_IR_LOCAL:
+			acpi_copy_object(&stack[sp], &state->local[op->index]);
+			sp++;
+			break;
+
+		case ACPI_IR_ARG:
+			acpi_copy_object(&stack[sp], &state->arg[op->index]);
+			sp++;
+			break;
+
+		case ACPI_IR_NAME:
+			acpi_ir_read_name(&stack[sp], op);
+			sp++;
+			break;
+
+		case ACPI_IR_AML:
+			acpi_eval_object(&stack[sp], state, op->aml);
+			sp++;
+			break;
+
+		case ACPI_IR_INVOKE:
+			// OS-defined methods and methods that didn't compile run
+			// through acpi_exec_method(), everything else gets a frame
+			handle = acpi_ir_resolve(op);
+			if(handle && handle->pointer && !handle->method_native)
+				invoke_ir = acpi_compile_cached(handle);
+			else
+				invoke_ir = NULL;
+
+			// through an Alias, the method still runs from its own scope
+			if(invoke_ir)
+			{
+				invoke_state = acpi_push_state(handle->path);
+				invoke_state->scope = handle->index;
+			} else
+			{
+				invoke_state = acpi_push_state(op->name);
+			}
+
+			// the arguments are moved off the stack into the new state
+			sp -= op->index;
+			for(i = 0; i < op->index; i++)
+				invoke_state->arg[i] = stack[sp + i];
+
+			if(!invoke_ir)
+			{
+				acpi_exec_method(invoke_state, &stack[sp]);
+				acpi_strcpy(context->path, state->name);
+				context->scope = state->scope;
+
+				acpi_pop_state(invoke_state);
+				sp++;
+				break;
+			}
+
+			// a pure method may have run with the same arguments already
+			if(invoke_ir->pure && acpi_ir_memo_lookup(invoke_ir, invoke_state, &stack[sp]))
+			{
+				acpi_pop_state(invoke_state);
+				sp++;
+				break;
+			}
+
+#ifdef ACPI_JIT
+			if(!acpi_jit_exec(invoke_ir, invoke_state, &stack[sp]))
+			{
+				acpi_pop_state(invoke_state);
+				sp++;
+				break;
+			}
+#endif
+
+			frame->ip = ip;
+			frame->sp = sp;
+
+			if(!acpi_ir_push_frame(invoke_ir, invoke_state))
+			{
+				// the invocation fails, as it does in acpi_exec_method()
+				acpi_strcpy(context->path, state->name);
+				context->scope = state->scope;
+
+				acpi_pop_state(invoke_state);
+				stack[sp].type = ACPI_INTEGER;
+				stack[sp].integer = 0;
+				sp++;
+				break;
+			}
+
+			frame = &context->ir_frames[context->ir_frame_count - 1];
+			ir = invoke_ir;
+			state = invoke_state;
+			ip = 0;
+			sp = 0;
+			stack = &context->ir_stack[frame->base];
+			break;
+
+		/* Stores leave the value on the stack, because it's also the result */
+		case ACPI_IR_STORE_LOCAL:
+			acpi_replace_object(&state->local[op->index], &stack[sp - 1]);
+			break;
+
+		case ACPI_IR_STORE_ARG:
+			acpi_replace_object(&state->arg[op->index], &stack[sp - 1]);
+			break;
+
+		case ACPI_IR_STORE_NAME:
+			acpi_ir_write_name(op, &stack[sp - 1]);
+			break;
+
+		case ACPI_IR_STORE_INDEX:
+			sp--;
+			acpi_ir_store_index(op, state, stack[sp].integer, &stack[sp - 1]);
+			break;
+
+		case ACPI_IR_DEFINE_NAME:
+			sp--;
+			acpi_ir_define_name(op, &stack[sp]);
+			break;
+
+		case ACPI_IR_EXEC:
+			acpi_ir_create_field(op, state);
+			break;
+
+		case ACPI_IR_POP:
+			sp--;
+			acpi_free_object(&stack[sp]);
+			break;
+
+		/* Control Flow */
+		case ACPI_IR_JUMP:
+			ACPI_IR_BRANCH(op, ip);
+			ip = op->target;
+			break;
+
+		case ACPI_IR_JUMP_ZERO:
+			sp--;
+			index.integer = stack[sp].integer;
+			acpi_free_object(&stack[sp]);
+
+			if(index.integer == 0)
+			{
+				ACPI_IR_BRANCH(op, ip);
+				ip = op->target;
+			}
+			break;
+
+		case ACPI_IR_SLEEP:
+			sp--;
+
+			// the caller of acpi_start_method() does the waiting, and
+			// continues from here with acpi_resume_method()
+			if(resumable)
+			{
+				context->wait.type = ACPI_WAIT_SLEEP;
+				context->wait.time = stack[sp].integer;
+				frame->ip = ip;
+				frame->sp = sp;
+				return ACPI_WOULD_BLOCK;
+			}
+
+			acpi_sleep(stack[sp].integer);
+			break;
+
+		case ACPI_IR_STALL:
+			sp--;
+			acpi_stall(stack[sp].integer);
+			break;
+
+		case ACPI_IR_TIMER:
+			stack[sp].type = ACPI_INTEGER;
+			stack[sp].integer = acpi_timer();
+			sp++;
+			break;
+
+		case ACPI_IR_ACQUIRE:
+			mutex = acpi_ir_mutex(op);
+
+			// with a timeout, the caller of acpi_start_method() waits for
+			// the owner instead, and acpi_resume_method() tries again here
+			if(resumable && op->integer)
+			{
+				status = acpi_try_mutex(mutex);
+				if(status == ACPI_WOULD_BLOCK)
+				{
+					// the deadline holds across the tries
+					if(context->wait.type != ACPI_WAIT_MUTEX || context->wait.mutex != mutex)
+					{
+						context->wait.type = ACPI_WAIT_MUTEX;
+						context->wait.mutex = mutex;
+						context->wait.time = (op->integer == ACPI_FOREVER) ? 0 : acpi_timer() + op->integer * 10000;
+					}
+
+					if(!context->wait.time || acpi_timer() < context->wait.time)
+					{
+						frame->ip = ip - 1;
+						frame->sp = sp;
+						return ACPI_WOULD_BLOCK;
+					}
+
+					status = 1;
+				}
+
+				context->wait.type = 0;
+				if(status)
+					status = 1;
+			} else
+				status = acpi_acquire_mutex(mutex, op->integer);
+
+			stack[sp].type = ACPI_INTEGER;
+			stack[sp].integer = status;
+			sp++;
+			break;
+
+		case ACPI_IR_RELEASE:
+			acpi_release_mutex(acpi_ir_mutex(op));
+			break;
+
+		case ACPI_IR_WAIT:
+			event = acpi_ir_event(op);
+
+			// like Acquire(), except that the OS resumes the method once
+			// it calls acpi_signal_event() or the deadline passes
+			if(resumable && stack[sp - 1].integer)
+			{
+				status = acpi_wait_event(event, 0);
+				if(status)
+				{
+					if(context->wait.type != ACPI_WAIT_EVENT || context->wait.event != event)
+					{
+						context->wait.type = ACPI_WAIT_EVENT;
+						context->wait.event = event;
+						context->wait.time = (stack[sp - 1].integer >= ACPI_FOREVER) ? 0 : acpi_timer() + stack[sp - 1].integer * 10000;
+					}
+
+					if(!context->wait.time || acpi_timer() < context->wait.time)
+					{
+						frame->ip = ip - 1;
+						frame->sp = sp;
+						return ACPI_WOULD_BLOCK;
+					}
+				}
+
+				context->wait.type = 0;
+			} else
+				status = acpi_wait_event(event, stack[sp - 1].integer);
+
+			stack[sp - 1].type = ACPI_INTEGER;
+			stack[sp - 1].integer = status;
+			break;
+
+		case ACPI_IR_SIGNAL:
+			acpi_signal_event(acpi_ir_event(op));
+			break;
+
+		case ACPI_IR_RESET:
+			acpi_reset_event(acpi_ir_event(op));
+			break;
+
+		case ACPI_IR_CONDREF:
+			stack[sp].type = ACPI_INTEGER;
+			stack[sp].integer = acpi_ir_resolve(op) ? 1 : 0;
+			sp++;
+			break;
+
+		case ACPI_IR_SIZEOF:
+			acpi_ir_sizeof(&stack[sp - 1]);
+			break;
+
+		case ACPI_IR_INDEX:
+			sp--;
+			acpi_ir_index(&stack[sp - 1], stack[sp].integer);
+			break;
+
+		/* Superinstructions */
+		case ACPI_IR_SET_LOCAL:
+			sp--;
+			acpi_free_object(&state->local[op->index]);
+			state->local[op->index] = stack[sp];
+			break;
+
+		case ACPI_IR_NAME_TO_LOCAL:
+			acpi_ir_read_name(&object, op);
+			acpi_free_object(&state->local[op->index]);
+			state->local[op->index] = object;
+			break;
+
+		case ACPI_IR_INCREMENT_LOCAL:
+			state->local[op->index].integer++;
+			break;
+
+		case ACPI_IR_DECREMENT_LOCAL:
+			state->local[op->index].integer--;
+			break;
+
+		case ACPI_IR_JUMP_LOCAL_NE:
+			if(state->local[op->index].integer != op->integer)
+			{
+				ACPI_IR_BRANCH(op, ip);
+				ip = op->target;
+			}
+			break;
+
+		case ACPI_IR_JUMP_LOCAL_GE:
+			if(state->local[op->index].integer >= op->integer)
+			{
+				ACPI_IR_BRANCH(op, ip);
+				ip = op->target;
+			}
+			break;
+
+		case ACPI_IR_JUMP_LOCAL_LE:
+			if(state->local[op->index].integer <= op->integer)
+			{
+				ACPI_IR_BRANCH(op, ip);
+				ip = op->target;
+			}
+			break;
+
+		case ACPI_IR_SHR_AND:
+			stack[sp - 1].type = ACPI_INTEGER;
+			stack[sp - 1].integer = (stack[sp - 1].integer >> op->index) & op->integer;
+			break;
+
+		/* Inlined methods */
+		case ACPI_IR_STACK:
+			acpi_copy_object(&stack[sp], &stack[op->index]);
+			sp++;
+			break;
+
+		case ACPI_IR_SLIDE:
+			sp--;
+			object = stack[sp];
+			for(i = 0; i < op->index; i++)
+			{
+				sp--;
+				acpi_free_object(&stack[sp]);
+			}
+
+			stack[sp] = object;
+			sp++;
+			break;
+
+		/* Arithmetic */
+		case ACPI_IR_INCREMENT:
+			stack[sp - 1].integer++;
+			break;
+
+		case ACPI_IR_DECREMENT:
+			stack[sp - 1].integer--;
+			break;
+
+		case ACPI_IR_NOT:
+			stack[sp - 1].type = ACPI_INTEGER;
+			stack[sp - 1].integer = ~stack[sp - 1].integer;
+			break;
+
+		case ACPI_IR_LNOT:
+			stack[sp - 1].type = ACPI_INTEGER;
+			stack[sp - 1].integer = (stack[sp - 1].integer == 0) ? 1 : 0;
+			break;
+
+		case ACPI_IR_DIVIDE:
+			if(stack[sp - 1].integer == 0)
+			{
+				acpi_panic("acpi: divide by zero in control method %s\n", state->name);
+			}
+
+			object.integer = stack[sp - 2].integer / stack[sp - 1].integer;
+			index.integer = stack[sp - 2].integer % stack[sp - 1].integer;
+
+			stack[sp - 2].type = ACPI_INTEGER;
+			stack[sp - 2].integer = object.integer;
+			stack[sp - 1].type = ACPI_INTEGER;
+			stack[sp - 1].integer = index.integer;
+			break;
+
+		default:
+			// everything left takes two integers and returns one
+			sp--;
+			object.integer = stack[sp - 1].integer;
+			index.integer = stack[sp].integer;
+
+			switch(op->opcode)
+			{
+			case ACPI_IR_ADD:
+				object.integer += index.integer;
+				break;
+			case ACPI_IR_SUBTRACT:
+				object.integer -= index.integer;
+				break;
+			case ACPI_IR_MULTIPLY:
+				object.integer *= index.integer;
+				break;
+			case ACPI_IR_AND:
+				object.integer &= index.integer;
+				break;
+			case ACPI_IR_OR:
+				object.integer |= index.integer;
+				break;
+			case ACPI_IR_XOR:
+				object.integer ^= index.integer;
+				break;
+			case ACPI_IR_SHL:
+				object.integer <<= index.integer;
+				break;
+			case ACPI_IR_SHR:
+				object.integer >>= index.integer;
+				break;
+			case ACPI_IR_LAND:
+				object.integer = (object.integer != 0 && index.integer != 0) ? 1 : 0;
+				break;
+			case ACPI_IR_LOR:
+				object.integer = (object.integer != 0 || index.integer != 0) ? 1 : 0;
+				break;
+			case ACPI_IR_LEQUAL:
+				object.integer = (object.integer == index.integer) ? 1 : 0;
+				break;
+			case ACPI_IR_LGREATER:
+				object.integer = (object.integer > index.integer) ? 1 : 0;
+				break;
+			case ACPI_IR_LLESS:
+				object.integer = (object.integer < index.integer) ? 1 : 0;
+				break;
+
+			default:
+				acpi_panic("acpi: undefined IR opcode %d in control method %s\n", op->opcode, state->name);
+			}
+
+			stack[sp - 1].type = ACPI_INTEGER;
+			stack[sp - 1].integer = object.integer;
+			break;
+		}
+	}
+}
+
+// acpi_ir_abort(): Unwinds the frames of a call that ran out of its budget
+// Param:	size_t entry - frames below this belong to callers in C
+// Param:	size_t sp - operand stack depth of the top frame
+// Param:	acpi_object_t *method_return - return value of the frame above entry
+// Return:	int - ACPI_ABORTED
+
+int acpi_ir_abort(size_t entry, size_t sp, acpi_object_t *method_return)
+{
+	acpi_context_t *context = acpi_context();
+	acpi_ir_frame_t *frame;
+	acpi_object_t *stack;
+
+	while(context->ir_frame_count > entry)
+	{
+		frame = &context->ir_frames[context->ir_frame_count - 1];
+		stack = &context->ir_stack[frame->base];
+		while(sp)
+		{
+			sp--;
+			acpi_free_object(&stack[sp]);
+		}
+
+		context->ir_frame_count--;
+
+		if(frame->mutex)
+			acpi_release_method_mutex(frame->mutex);
+
+		// the state of the frame above entry belongs to its caller
+		if(context->ir_frame_count > entry)
+		{
+			acpi_pop_state(frame->state);
+			sp = frame[-1].sp;
+		}
+	}
+
+	method_return->type = ACPI_INTEGER;
+	method_return->integer = 0;
+	return ACPI_ABORTED;
+}
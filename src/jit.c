@@ -0,0 +1,624 @@
+
+/*
+ * Lux ACPI Implementation
+ * Copyright (C) 2018 by Omar Mohammad
+ */
+
+/* ACPI Control Method JIT */
+/* Optional, built with ACPI_JIT on x86-64. Methods that keep running through
+ * acpi_ir_exec(), like GPE handlers and _TMP, are translated into native code
+ * once they're hot. Every IR opcode has a fixed template, and the operand
+ * stack becomes fixed slots in a frame of integers, so only methods that deal
+ * in nothing but integers qualify: Locals, Args, arithmetic, comparisons,
+ * branches and Field reads. Everything else stays in the interpreter.
+ * With ACPI_JIT_VERIFY, every native run is repeated by the interpreter and the
+ * results compared; that's for hosted builds, as Field reads happen twice. */
+
+#include "lai.h"
+
+#ifdef ACPI_JIT
+
+#define ACPI_JIT_TEMPLATE		64	// longest template, in bytes
+#define ACPI_JIT_LOCALS			0	// frame slots, 8 locals, 7 args, then the operand stack
+#define ACPI_JIT_ARGS			8
+#define ACPI_JIT_STACK			15
+
+typedef struct acpi_jit_t
+{
+	uint8_t *code;
+	size_t size;
+
+	size_t *offset;			// native offset of every IR instruction, and of the end
+	size_t *depth;			// operand stack depth before every IR instruction
+	size_t *fixup;			// rel32 operands of jumps, and the instruction they jump to
+	size_t *fixup_target;
+	size_t fixups;
+} acpi_jit_t;
+
+typedef uint64_t (*acpi_jit_entry_t)(uint64_t *, acpi_state_t *);
+
+int acpi_jit_depths(acpi_ir_t *, size_t *);
+void *acpi_jit_compile(acpi_ir_t *);
+void acpi_jit_byte(acpi_jit_t *, uint8_t);
+void acpi_jit_bytes(acpi_jit_t *, const char *, size_t);
+void acpi_jit_qword(acpi_jit_t *, uint64_t);
+void acpi_jit_slot(acpi_jit_t *, const char *, size_t);
+void acpi_jit_call(acpi_jit_t *, void *);
+void acpi_jit_jump(acpi_jit_t *, const char *, size_t, size_t);
+uint64_t acpi_jit_read_name(acpi_irop_t *);
+void acpi_jit_divide_zero(acpi_state_t *);
+
+// acpi_jit_exec(): Runs a compiled method as native code, if it qualifies
+// Param:	acpi_ir_t *ir - compiled method
+// Param:	acpi_state_t *state - machine state, with the arguments
+// Param:	acpi_object_t *method_return - return value of method
+// Return:	int - 0 if it ran, 1 if the interpreter has to run it
+
+int acpi_jit_exec(acpi_ir_t *ir, acpi_state_t *state, acpi_object_t *method_return)
+{
+	uint64_t frame[ACPI_JIT_STACK + ACPI_IR_MAX_STACK];
+	void *code;
+	size_t i;
+
+	if(ir->jit_failed)
+		return 1;
+
+#ifdef ACPI_JIT_VERIFY
+	if(acpi_context()->jit_verifying)
+		return 1;
+#endif
+
+	// published after the code is written, for other threads
+	code = __atomic_load_n(&ir->jit, __ATOMIC_ACQUIRE);
+	if(!code)
+	{
+		// cold methods aren't worth the executable memory, and the count
+		// doesn't have to be exact
+		ir->jit_runs++;
+		if(ir->jit_runs < ACPI_JIT_THRESHOLD)
+			return 1;
+
+		// another thread may be compiling it already
+		ACPI_LOCK(&acpi_namespace_lock);
+		code = ir->jit;
+		if(!code && !ir->jit_failed)
+		{
+			code = acpi_jit_compile(ir);
+			if(!code)
+				ir->jit_failed = 1;
+			__atomic_store_n(&ir->jit, code, __ATOMIC_RELEASE);
+		}
+		ACPI_UNLOCK(&acpi_namespace_lock);
+
+		if(!code)
+			return 1;
+	}
+
+	// the native code has no types, so the arguments had better be integers
+	for(i = 0; i < ir->argc; i++)
+	{
+		if(state->arg[i].type != ACPI_INTEGER)
+			return 1;
+	}
+
+	for(i = 0; i < 8; i++)
+		frame[ACPI_JIT_LOCALS + i] = 0;
+	for(i = 0; i < 7; i++)
+		frame[ACPI_JIT_ARGS + i] = state->arg[i].integer;
+
+	method_return->type = ACPI_INTEGER;
+	method_return->integer = ((acpi_jit_entry_t)code)(frame, state);
+
+#ifdef ACPI_JIT_VERIFY
+	// the locals are untouched and the arguments only changed in the frame,
+	// so the interpreter starts from the same state
+	acpi_object_t expected = {0};
+	acpi_context()->jit_verifying = 1;
+	acpi_ir_exec(ir, state, &expected);
+	acpi_context()->jit_verifying = 0;
+
+	if(expected.type != ACPI_INTEGER || expected.integer != method_return->integer)
+	{
+		acpi_panic("acpi: JIT returned 0x%lx for %s, interpreter returned 0x%lx\n", method_return->integer, state->name, expected.integer);
+	}
+#endif
+
+	if(ir->pure)
+		acpi_ir_memo_store(ir, state, method_return);
+
+	return 0;
+}
+
+// acpi_jit_depths(): Works out the operand stack depth before every instruction
+// Param:	acpi_ir_t *ir - compiled method
+// Param:	size_t *depth - one per instruction and one for the end, (size_t)-1 until known
+// Return:	int - 0 if every instruction qualifies for the JIT
+
+int acpi_jit_depths(acpi_ir_t *ir, size_t *depth)
+{
+	acpi_irop_t *op;
+	acpi_handle_t *handle;
+	size_t sp = 0, ip;
+	int reachable = 1;		// whether the previous instruction falls through
+
+	// Serialized methods take their mutex in acpi_ir_push_frame(), which
+	// native code never goes through
+	if(ir->mutex)
+		return 1;
+
+	for(ip = 0; ip <= ir->count; ip++)
+	{
+		// code after a jump or Return is only reached by jumps seen before
+		if(!reachable)
+		{
+			if(depth[ip] == (size_t)-1 && ip == ir->count)
+				break;
+			if(depth[ip] == (size_t)-1)
+				return 1;
+			sp = depth[ip];
+		} else if(depth[ip] != (size_t)-1 && depth[ip] != sp)
+			return 1;
+
+		depth[ip] = sp;
+		reachable = 1;
+
+		if(ip == ir->count)
+			break;
+
+		op = &ir->code[ip];
+		switch(op->opcode)
+		{
+		case ACPI_IR_NAME:
+		case ACPI_IR_NAME_TO_LOCAL:
+			// Fields always read as integers, Name()s may not
+			handle = acpi_ir_resolve(op);
+			if(!handle || (handle->type != ACPI_NAMESPACE_FIELD && handle->type != ACPI_NAMESPACE_INDEXFIELD))
+				return 1;
+			if(op->opcode == ACPI_IR_NAME)
+				sp++;
+			break;
+
+		case ACPI_IR_INTEGER:
+		case ACPI_IR_LOCAL:
+		case ACPI_IR_ARG:
+			sp++;
+			break;
+
+		case ACPI_IR_POP:
+		case ACPI_IR_SET_LOCAL:
+			if(!sp)
+				return 1;
+			sp--;
+			break;
+
+		case ACPI_IR_STORE_LOCAL:
+		case ACPI_IR_STORE_ARG:
+		case ACPI_IR_INCREMENT:
+		case ACPI_IR_DECREMENT:
+		case ACPI_IR_NOT:
+		case ACPI_IR_LNOT:
+		case ACPI_IR_SHR_AND:
+			if(!sp)
+				return 1;
+			break;
+
+		case ACPI_IR_DIVIDE:
+			if(sp < 2)
+				return 1;
+			break;
+
+		case ACPI_IR_ADD:
+		case ACPI_IR_SUBTRACT:
+		case ACPI_IR_MULTIPLY:
+		case ACPI_IR_AND:
+		case ACPI_IR_OR:
+		case ACPI_IR_XOR:
+		case ACPI_IR_SHL:
+		case ACPI_IR_SHR:
+		case ACPI_IR_LAND:
+		case ACPI_IR_LOR:
+		case ACPI_IR_LEQUAL:
+		case ACPI_IR_LGREATER:
+		case ACPI_IR_LLESS:
+			if(sp < 2)
+				return 1;
+			sp--;
+			break;
+
+		case ACPI_IR_INCREMENT_LOCAL:
+		case ACPI_IR_DECREMENT_LOCAL:
+			break;
+
+		case ACPI_IR_STACK:
+			if(op->index >= sp)
+				return 1;
+			sp++;
+			break;
+
+		case ACPI_IR_SLIDE:
+			if(sp < op->index + 1)
+				return 1;
+			sp -= op->index;
+			break;
+
+		case ACPI_IR_JUMP_ZERO:
+			if(!sp)
+				return 1;
+			sp--;
+			// fall through
+		case ACPI_IR_JUMP:
+		case ACPI_IR_JUMP_LOCAL_NE:
+		case ACPI_IR_JUMP_LOCAL_GE:
+		case ACPI_IR_JUMP_LOCAL_LE:
+			if(op->target > ir->count)
+				return 1;
+#ifdef ACPI_BUDGET
+			// native loops couldn't be aborted, so they stay in the IR
+			if(op->target <= ip)
+				return 1;
+#endif
+			if(depth[op->target] != (size_t)-1 && depth[op->target] != sp)
+				return 1;
+
+			depth[op->target] = sp;
+			if(op->opcode == ACPI_IR_JUMP)
+				reachable = 0;
+			break;
+
+		case ACPI_IR_RETURN:
+			if(!sp)
+				return 1;
+			reachable = 0;
+			break;
+
+		default:
+			return 1;
+		}
+
+		if(sp > ir->stack_size || sp > ACPI_IR_MAX_STACK)
+			return 1;
+	}
+
+	return 0;
+}
+
+// acpi_jit_compile(): Translates a compiled method into native code
+// Param:	acpi_ir_t *ir - compiled method
+// Return:	void * - entry point, NULL if the method doesn't qualify
+
+void *acpi_jit_compile(acpi_ir_t *ir)
+{
+	acpi_jit_t jit;
+	acpi_irop_t *op;
+	size_t ip, sp, top, i;
+	int32_t rel;
+	void *entry = NULL;
+
+	jit.code = acpi_malloc((ir->count + 2) * ACPI_JIT_TEMPLATE);
+	jit.size = 0;
+	jit.offset = acpi_malloc((ir->count + 1) * sizeof(size_t));
+	jit.depth = acpi_malloc((ir->count + 1) * sizeof(size_t));
+	jit.fixup = acpi_malloc((ir->count + 1) * sizeof(size_t));
+	jit.fixup_target = acpi_malloc((ir->count + 1) * sizeof(size_t));
+	jit.fixups = 0;
+
+	for(ip = 0; ip <= ir->count; ip++)
+		jit.depth[ip] = (size_t)-1;
+
+	if(acpi_jit_depths(ir, jit.depth))
+		goto done;
+
+	// push rbx; push r12; push rbp, which also aligns the stack for calls
+	// mov rbx, rdi (the frame); mov r12, rsi (the state)
+	acpi_jit_bytes(&jit, "\x53\x41\x54\x55\x48\x89\xFB\x49\x89\xF4", 10);
+
+	for(ip = 0; ip < ir->count; ip++)
+	{
+		op = &ir->code[ip];
+		sp = jit.depth[ip];
+		top = ACPI_JIT_STACK + sp - 1;		// slot of the top of the operand stack
+		jit.offset[ip] = jit.size;
+
+		switch(op->opcode)
+		{
+		case ACPI_IR_INTEGER:
+			acpi_jit_bytes(&jit, "\x48\xB8", 2);		// mov rax, imm64
+			acpi_jit_qword(&jit, op->integer);
+			acpi_jit_slot(&jit, "\x48\x89\x83", top + 1);	// mov [slot], rax
+			break;
+
+		case ACPI_IR_LOCAL:
+		case ACPI_IR_ARG:
+			i = (op->opcode == ACPI_IR_LOCAL) ? ACPI_JIT_LOCALS : ACPI_JIT_ARGS;
+			acpi_jit_slot(&jit, "\x48\x8B\x83", i + op->index);	// mov rax, [slot]
+			acpi_jit_slot(&jit, "\x48\x89\x83", top + 1);
+			break;
+
+		case ACPI_IR_NAME:
+		case ACPI_IR_NAME_TO_LOCAL:
+			acpi_jit_bytes(&jit, "\x48\xBF", 2);		// mov rdi, imm64
+			acpi_jit_qword(&jit, (uint64_t)(size_t)op);
+			acpi_jit_call(&jit, acpi_jit_read_name);
+
+			if(op->opcode == ACPI_IR_NAME)
+				acpi_jit_slot(&jit, "\x48\x89\x83", top + 1);
+			else
+				acpi_jit_slot(&jit, "\x48\x89\x83", ACPI_JIT_LOCALS + op->index);
+			break;
+
+		case ACPI_IR_STORE_LOCAL:
+		case ACPI_IR_STORE_ARG:
+		case ACPI_IR_SET_LOCAL:
+			i = (op->opcode == ACPI_IR_STORE_ARG) ? ACPI_JIT_ARGS : ACPI_JIT_LOCALS;
+			acpi_jit_slot(&jit, "\x48\x8B\x83", top);
+			acpi_jit_slot(&jit, "\x48\x89\x83", i + op->index);
+			break;
+
+		case ACPI_IR_POP:
+			break;
+
+		case ACPI_IR_STACK:
+			acpi_jit_slot(&jit, "\x48\x8B\x83", ACPI_JIT_STACK + op->index);
+			acpi_jit_slot(&jit, "\x48\x89\x83", top + 1);
+			break;
+
+		case ACPI_IR_SLIDE:
+			acpi_jit_slot(&jit, "\x48\x8B\x83", top);
+			acpi_jit_slot(&jit, "\x48\x89\x83", top - op->index);
+			break;
+
+		case ACPI_IR_INCREMENT:
+			acpi_jit_slot(&jit, "\x48\xFF\x83", top);		// inc qword [slot]
+			break;
+
+		case ACPI_IR_DECREMENT:
+			acpi_jit_slot(&jit, "\x48\xFF\x8B", top);		// dec qword [slot]
+			break;
+
+		case ACPI_IR_INCREMENT_LOCAL:
+			acpi_jit_slot(&jit, "\x48\xFF\x83", ACPI_JIT_LOCALS + op->index);
+			break;
+
+		case ACPI_IR_DECREMENT_LOCAL:
+			acpi_jit_slot(&jit, "\x48\xFF\x8B", ACPI_JIT_LOCALS + op->index);
+			break;
+
+		case ACPI_IR_NOT:
+			acpi_jit_slot(&jit, "\x48\xF7\x93", top);		// not qword [slot]
+			break;
+
+		case ACPI_IR_LNOT:
+			acpi_jit_slot(&jit, "\x48\x8B\x83", top);
+			acpi_jit_bytes(&jit, "\x48\x85\xC0\x0F\x94\xC0\x0F\xB6\xC0", 9);	// test rax, rax; sete al; movzx eax, al
+			acpi_jit_slot(&jit, "\x48\x89\x83", top);
+			break;
+
+		case ACPI_IR_SHR_AND:
+			acpi_jit_slot(&jit, "\x48\x8B\x83", top);
+			acpi_jit_bytes(&jit, "\x48\xC1\xE8", 3);		// shr rax, imm8
+			acpi_jit_byte(&jit, op->index);
+			acpi_jit_bytes(&jit, "\x48\xB9", 2);		// mov rcx, imm64
+			acpi_jit_qword(&jit, op->integer);
+			acpi_jit_bytes(&jit, "\x48\x21\xC8", 3);		// and rax, rcx
+			acpi_jit_slot(&jit, "\x48\x89\x83", top);
+			break;
+
+		case ACPI_IR_DIVIDE:
+			acpi_jit_slot(&jit, "\x48\x8B\x83", top - 1);
+			acpi_jit_slot(&jit, "\x48\x8B\x8B", top);		// mov rcx, [slot]
+			acpi_jit_bytes(&jit, "\x48\x85\xC9\x75\x0F", 5);	// test rcx, rcx; jnz over the call
+			acpi_jit_bytes(&jit, "\x4C\x89\xE7", 3);		// mov rdi, r12
+			acpi_jit_call(&jit, acpi_jit_divide_zero);
+			acpi_jit_bytes(&jit, "\x31\xD2\x48\xF7\xF1", 5);	// xor edx, edx; div rcx
+			acpi_jit_slot(&jit, "\x48\x89\x83", top - 1);
+			acpi_jit_slot(&jit, "\x48\x89\x93", top);		// mov [slot], rdx
+			break;
+
+		case ACPI_IR_ADD:
+		case ACPI_IR_SUBTRACT:
+		case ACPI_IR_MULTIPLY:
+		case ACPI_IR_AND:
+		case ACPI_IR_OR:
+		case ACPI_IR_XOR:
+		case ACPI_IR_SHL:
+		case ACPI_IR_SHR:
+		case ACPI_IR_LAND:
+		case ACPI_IR_LOR:
+		case ACPI_IR_LEQUAL:
+		case ACPI_IR_LGREATER:
+		case ACPI_IR_LLESS:
+			acpi_jit_slot(&jit, "\x48\x8B\x83", top - 1);
+			acpi_jit_slot(&jit, "\x48\x8B\x8B", top);
+
+			if(op->opcode == ACPI_IR_ADD)
+				acpi_jit_bytes(&jit, "\x48\x01\xC8", 3);
+			else if(op->opcode == ACPI_IR_SUBTRACT)
+				acpi_jit_bytes(&jit, "\x48\x29\xC8", 3);
+			else if(op->opcode == ACPI_IR_MULTIPLY)
+				acpi_jit_bytes(&jit, "\x48\x0F\xAF\xC1", 4);
+			else if(op->opcode == ACPI_IR_AND)
+				acpi_jit_bytes(&jit, "\x48\x21\xC8", 3);
+			else if(op->opcode == ACPI_IR_OR)
+				acpi_jit_bytes(&jit, "\x48\x09\xC8", 3);
+			else if(op->opcode == ACPI_IR_XOR)
+				acpi_jit_bytes(&jit, "\x48\x31\xC8", 3);
+			else if(op->opcode == ACPI_IR_SHL)
+				acpi_jit_bytes(&jit, "\x48\xD3\xE0", 3);		// like C, the count is taken mod 64
+			else if(op->opcode == ACPI_IR_SHR)
+				acpi_jit_bytes(&jit, "\x48\xD3\xE8", 3);
+			else if(op->opcode == ACPI_IR_LAND)
+				acpi_jit_bytes(&jit, "\x48\x85\xC0\x0F\x95\xC0\x48\x85\xC9\x0F\x95\xC1\x20\xC8\x0F\xB6\xC0", 17);
+			else if(op->opcode == ACPI_IR_LOR)
+				acpi_jit_bytes(&jit, "\x48\x09\xC8\x0F\x95\xC0\x0F\xB6\xC0", 9);
+			else if(op->opcode == ACPI_IR_LEQUAL)
+				acpi_jit_bytes(&jit, "\x48\x39\xC8\x0F\x94\xC0\x0F\xB6\xC0", 9);
+			else if(op->opcode == ACPI_IR_LGREATER)
+				acpi_jit_bytes(&jit, "\x48\x39\xC8\x0F\x97\xC0\x0F\xB6\xC0", 9);
+			else
+				acpi_jit_bytes(&jit, "\x48\x39\xC8\x0F\x92\xC0\x0F\xB6\xC0", 9);
+
+			acpi_jit_slot(&jit, "\x48\x89\x83", top - 1);
+			break;
+
+		/* Control Flow */
+		case ACPI_IR_JUMP:
+			acpi_jit_jump(&jit, "\xE9", 1, op->target);
+			break;
+
+		case ACPI_IR_JUMP_ZERO:
+			acpi_jit_slot(&jit, "\x48\x8B\x83", top);
+			acpi_jit_bytes(&jit, "\x48\x85\xC0", 3);
+			acpi_jit_jump(&jit, "\x0F\x84", 2, op->target);	// jz
+			break;
+
+		case ACPI_IR_JUMP_LOCAL_NE:
+		case ACPI_IR_JUMP_LOCAL_GE:
+		case ACPI_IR_JUMP_LOCAL_LE:
+			acpi_jit_slot(&jit, "\x48\x8B\x83", ACPI_JIT_LOCALS + op->index);
+			acpi_jit_bytes(&jit, "\x48\xB9", 2);
+			acpi_jit_qword(&jit, op->integer);
+			acpi_jit_bytes(&jit, "\x48\x39\xC8", 3);		// cmp rax, rcx
+
+			if(op->opcode == ACPI_IR_JUMP_LOCAL_NE)
+				acpi_jit_jump(&jit, "\x0F\x85", 2, op->target);	// jne
+			else if(op->opcode == ACPI_IR_JUMP_LOCAL_GE)
+				acpi_jit_jump(&jit, "\x0F\x83", 2, op->target);	// jae
+			else
+				acpi_jit_jump(&jit, "\x0F\x86", 2, op->target);	// jbe
+			break;
+
+		case ACPI_IR_RETURN:
+			acpi_jit_slot(&jit, "\x48\x8B\x83", top);
+			acpi_jit_bytes(&jit, "\x5D\x41\x5C\x5B\xC3", 5);	// pop rbp; pop r12; pop rbx; ret
+			break;
+		}
+	}
+
+	// when it returns nothing, assume Return (0)
+	jit.offset[ir->count] = jit.size;
+	acpi_jit_bytes(&jit, "\x31\xC0\x5D\x41\x5C\x5B\xC3", 7);
+
+	for(i = 0; i < jit.fixups; i++)
+	{
+		rel = (int32_t)(jit.offset[jit.fixup_target[i]] - (jit.fixup[i] + 4));
+		acpi_memcpy(&jit.code[jit.fixup[i]], &rel, 4);
+	}
+
+	entry = acpi_jit_map(jit.size);
+	if(entry)
+		acpi_memcpy(entry, jit.code, jit.size);
+
+done:
+	acpi_free(jit.code);
+	acpi_free(jit.offset);
+	acpi_free(jit.depth);
+	acpi_free(jit.fixup);
+	acpi_free(jit.fixup_target);
+	return entry;
+}
+
+// acpi_jit_byte(): Emits a byte of native code
+// Param:	acpi_jit_t *jit - JIT state
+// Param:	uint8_t byte - byte
+// Return:	Nothing
+
+void acpi_jit_byte(acpi_jit_t *jit, uint8_t byte)
+{
+	jit->code[jit->size] = byte;
+	jit->size++;
+}
+
+// acpi_jit_bytes(): Emits a fixed sequence of native code
+// Param:	acpi_jit_t *jit - JIT state
+// Param:	const char *bytes - instruction bytes
+// Param:	size_t count - number of bytes
+// Return:	Nothing
+
+void acpi_jit_bytes(acpi_jit_t *jit, const char *bytes, size_t count)
+{
+	acpi_memcpy(&jit->code[jit->size], bytes, count);
+	jit->size += count;
+}
+
+// acpi_jit_qword(): Emits a 64-bit immediate
+// Param:	acpi_jit_t *jit - JIT state
+// Param:	uint64_t qword - immediate
+// Return:	Nothing
+
+void acpi_jit_qword(acpi_jit_t *jit, uint64_t qword)
+{
+	acpi_memcpy(&jit->code[jit->size], &qword, 8);
+	jit->size += 8;
+}
+
+// acpi_jit_slot(): Emits an instruction with a frame slot as its memory operand
+// Param:	acpi_jit_t *jit - JIT state
+// Param:	const char *prefix - REX, opcode and ModRM with [rbx+disp32]
+// Param:	size_t slot - frame slot
+// Return:	Nothing
+
+void acpi_jit_slot(acpi_jit_t *jit, const char *prefix, size_t slot)
+{
+	uint32_t displacement = (uint32_t)(slot * sizeof(uint64_t));
+
+	acpi_jit_bytes(jit, prefix, 3);
+	acpi_memcpy(&jit->code[jit->size], &displacement, 4);
+	jit->size += 4;
+}
+
+// acpi_jit_call(): Emits a call to a C function
+// Param:	acpi_jit_t *jit - JIT state
+// Param:	void *function - function, arguments are already in place
+// Return:	Nothing
+
+void acpi_jit_call(acpi_jit_t *jit, void *function)
+{
+	// mov rax, imm64; call rax
+	acpi_jit_bytes(jit, "\x48\xB8", 2);
+	acpi_jit_qword(jit, (uint64_t)(size_t)function);
+	acpi_jit_bytes(jit, "\xFF\xD0", 2);
+}
+
+// acpi_jit_jump(): Emits a jump to an IR instruction, patched once all are emitted
+// Param:	acpi_jit_t *jit - JIT state
+// Param:	const char *opcode - jmp or jcc opcode, with a rel32 operand
+// Param:	size_t count - size of the opcode
+// Param:	size_t target - IR instruction to jump to
+// Return:	Nothing
+
+void acpi_jit_jump(acpi_jit_t *jit, const char *opcode, size_t count, size_t target)
+{
+	acpi_jit_bytes(jit, opcode, count);
+
+	jit->fixup[jit->fixups] = jit->size;
+	jit->fixup_target[jit->fixups] = target;
+	jit->fixups++;
+
+	jit->size += 4;
+}
+
+// acpi_jit_read_name(): Reads a Field from native code
+// Param:	acpi_irop_t *op - instruction with the full path
+// Return:	uint64_t - value of the field
+
+uint64_t acpi_jit_read_name(acpi_irop_t *op)
+{
+	acpi_object_t object = {0};
+	uint64_t integer;
+
+	acpi_ir_read_name(&object, op);
+	integer = object.integer;
+	acpi_free_object(&object);
+	return integer;
+}
+
+// acpi_jit_divide_zero(): Reports a division by zero in native code
+// Param:	acpi_state_t *state - machine state
+// Return:	Nothing
+
+void acpi_jit_divide_zero(acpi_state_t *state)
+{
+	acpi_panic("acpi: divide by zero in control method %s\n", state->name);
+}
+
+#endif
@@ -16,8 +16,15 @@
 #define ACPI_GAS_IO			1
 #define ACPI_GAS_PCI			2
 
-#define ACPI_MAX_NAMESPACE_ENTRIES	128	// realloc()'d, to save memory
-#define ACPI_MAX_PACKAGE_ENTRIES	256	// for Package() because the size is 8 bits, VarPackage() is unlimited
+#define ACPI_MAX_NAMESPACE_ENTRIES	128	// per block of the namespace, allocated as it grows
+#define ACPI_POOL_ENTRIES		6	// packages up to this many entries are pooled, _PSS has 6
+#define ACPI_ARENA_SIZE			65536	// temporaries of a method call, beyond that they use the heap
+#define ACPI_JIT_THRESHOLD		64	// runs of a compiled method before it's considered hot, with ACPI_JIT
+#define ACPI_BUDGET_CLOCK		64	// loop iterations between checks of the deadline, with ACPI_BUDGET
+
+#if defined(ACPI_JIT) && !defined(__x86_64__)
+#error "lai: the JIT only emits x86-64 code"
+#endif
 
 #define ACPI_NAMESPACE_NAME		1
 #define ACPI_NAMESPACE_ALIAS		2
@@ -30,6 +37,7 @@
 #define ACPI_NAMESPACE_PROCESSOR	9
 #define ACPI_NAMESPACE_BUFFER_FIELD	10
 #define ACPI_NAMESPACE_THERMALZONE	11
+#define ACPI_NAMESPACE_EVENT		12
 
 #define ACPI_INTEGER			1
 #define ACPI_STRING			2
@@ -37,9 +45,12 @@
 #define ACPI_BUFFER			4
 #define ACPI_NAME			5
 
-// AML VM States
-#define ACPI_STATUS_WHILE		1
-#define ACPI_STATUS_CONDITIONAL		2
+// AML VM Blocks
+#define ACPI_BLOCK_IF			1
+#define ACPI_BLOCK_ELSE			2
+#define ACPI_BLOCK_WHILE		3
+
+#define ACPI_MAX_BLOCKS			16
 
 // Device _STA object
 #define ACPI_STA_PRESENT		0x01
@@ -47,6 +58,7 @@
 #define ACPI_STA_VISIBLE		0x04
 #define ACPI_STA_FUNCTION		0x08
 #define ACPI_STA_BATTERY		0x10
+#define ACPI_STA_DEFAULT		(ACPI_STA_PRESENT | ACPI_STA_ENABLED | ACPI_STA_VISIBLE | ACPI_STA_FUNCTION)
 
 // FADT Event/Status Fields
 #define ACPI_TIMER			0x0001
@@ -62,6 +74,11 @@
 #define ACPI_ENABLED			0x0001
 #define ACPI_SLEEP			0x2000
 
+// FADT Flags
+#define ACPI_TIMER_32BIT		0x0100	// TMR_VAL_EXT
+
+#define ACPI_PM_TIMER_FREQUENCY		3579545	// Hz
+
 // Parsing Resource Templates
 #define ACPI_RESOURCE_MEMORY		1
 #define ACPI_RESOURCE_IO		2
@@ -188,26 +205,185 @@ typedef struct acpi_aml_t		// AML tables, DSDT and SSDT
 	uint8_t data[];
 }__attribute__((packed)) acpi_aml_t;
 
+// Objects are copied around a lot, so they're kept to 16 bytes
+// Only the fields for the object's type are valid, the rest overlap them
+// Buffers, Packages and Name References point to reference-counted data, see
+// acpi_alloc_counted(), Strings always point to constant data
+// Within a control method, that data comes from an arena, and anything that
+// outlives the method is moved out of it with acpi_persist_object()
 typedef struct acpi_object_t
 {
 	int type;
-	uint64_t integer;		// for Name()
-	char *string;			// for Name()
 
-	int package_size;		// for Package(), size in entries
-	struct acpi_object_t *package;	// for Package(), actual entries
+	union
+	{
+		int package_size;		// for Package(), size in entries
+		uint32_t buffer_size;		// for Buffer(), size in bytes
+	};
+
+	union
+	{
+		uint64_t integer;		// for Integers
+		char *string;			// for Strings
+		struct acpi_object_t *package;	// for Package(), actual entries
+		void *buffer;			// for Buffer(), actual bytes
+		char *name;			// for Name References, full path
+	};
+} acpi_object_t;
+
+// Pre-decoded method IR, the compiler translates AML into these
+// Operands are kept on a stack, so every opcode below pops its operands and pushes its result
+#define ACPI_IR_INTEGER			1	// integer constant
+#define ACPI_IR_STRING			2	// string constant, in the AML
+#define ACPI_IR_LOCAL			3	// LocalX
+#define ACPI_IR_ARG			4	// ArgX
+#define ACPI_IR_NAME			5	// read a Name() or a Field
+#define ACPI_IR_INVOKE			6	// MethodInvokation, pops the arguments
+#define ACPI_IR_AML			7	// object that is still evaluated from AML, Package() and Buffer()
+#define ACPI_IR_STORE_LOCAL		8	// the store opcodes don't pop the stored value
+#define ACPI_IR_STORE_ARG		9
+#define ACPI_IR_STORE_NAME		10
+#define ACPI_IR_STORE_INDEX		11	// pops the index; integer/index/name say where the package is held
+#define ACPI_IR_POP			12
+#define ACPI_IR_JUMP			13
+#define ACPI_IR_JUMP_ZERO		14
+#define ACPI_IR_RETURN			15
+#define ACPI_IR_BREAK			16	// only while compiling, becomes ACPI_IR_JUMP
+#define ACPI_IR_EXEC			17	// statement that is still executed from AML, CreateXField()
+#define ACPI_IR_DEFINE_NAME		18	// Name() within a method
+#define ACPI_IR_SLEEP			19
+#define ACPI_IR_CONDREF			20
+#define ACPI_IR_SIZEOF			21
+#define ACPI_IR_INDEX			22
+#define ACPI_IR_INCREMENT		23
+#define ACPI_IR_DECREMENT		24
+#define ACPI_IR_ADD			25
+#define ACPI_IR_SUBTRACT		26
+#define ACPI_IR_MULTIPLY		27
+#define ACPI_IR_DIVIDE			28	// pushes the quotient and then the remainder
+#define ACPI_IR_AND			29
+#define ACPI_IR_OR			30
+#define ACPI_IR_XOR			31
+#define ACPI_IR_NOT			32
+#define ACPI_IR_SHL			33
+#define ACPI_IR_SHR			34
+#define ACPI_IR_LAND			35
+#define ACPI_IR_LOR			36
+#define ACPI_IR_LNOT			37
+#define ACPI_IR_LEQUAL			38
+#define ACPI_IR_LGREATER		39
+#define ACPI_IR_LLESS			40
+
+// Superinstructions, acpi_compile_fuse() makes these out of common sequences
+#define ACPI_IR_SET_LOCAL		41	// Store() to LocalX as a statement, pops the value
+#define ACPI_IR_NAME_TO_LOCAL		42	// Store() of a Name() or a Field to LocalX
+#define ACPI_IR_INCREMENT_LOCAL		43
+#define ACPI_IR_DECREMENT_LOCAL		44
+#define ACPI_IR_JUMP_LOCAL_NE		45	// If(LEqual(LocalX, integer)), jumps when false
+#define ACPI_IR_JUMP_LOCAL_GE		46	// If(LLess(LocalX, integer)) and While() alike
+#define ACPI_IR_JUMP_LOCAL_LE		47	// If(LGreater(LocalX, integer))
+#define ACPI_IR_SHR_AND			48	// And(ShiftRight(x, index), integer)
+#define ACPI_IR_NOP			49	// only while compiling, for instructions folded away
+
+// Inlined methods, see acpi_compile_inline()
+#define ACPI_IR_STACK			50	// pushes a copy of operand stack slot index, for the callee's ArgX
+#define ACPI_IR_SLIDE			51	// drops the index objects under the top, the callee's arguments
+
+#define ACPI_IR_STALL			52
+#define ACPI_IR_TIMER			53	// pushes acpi_timer()
+#define ACPI_IR_ACQUIRE			54	// name is the mutex, integer the timeout
+#define ACPI_IR_RELEASE			55
+#define ACPI_IR_WAIT			56	// name is the event, replaces the timeout with 1 when it ran out
+#define ACPI_IR_SIGNAL			57
+#define ACPI_IR_RESET			58
+
+#define ACPI_IR_MAX_STACK		16	// methods that need more fall back to the AML interpreter
+#define ACPI_IR_MAX_DEPTH		32	// nested calls between compiled methods
+#define ACPI_INLINE_DEPTH		4	// methods being compiled at once, as callees compile for inlining
+
+typedef struct acpi_irop_t
+{
+	uint8_t opcode;			// ACPI_IR_*
+	uint8_t index;			// LocalX/ArgX number, argument count, or AML opcode for ACPI_IR_EXEC
+	uint32_t target;		// for jumps, index of target instruction
+	uint64_t integer;		// for integer constants
+	uint8_t *aml;			// for strings and for opcodes still backed by AML
+	char *name;			// for names, full path
 
-	size_t buffer_size;		// for Buffer(), size in bytes
-	void *buffer;			// for Buffer(), actual bytes
+	size_t handle;			// for names, index of the cached namespace object
+	size_t generation;		// acpi_namespace_generation when the above was cached
+} acpi_irop_t;
 
-	char name[ACPI_MAX_NAME];	// for Name References
-} acpi_object_t;
+#define ACPI_MEMO_ENTRIES		4	// results kept per pure method, replaced round-robin
+
+// Result of a pure method for one set of Integer arguments
+typedef struct acpi_memo_t
+{
+	int valid;
+	uint64_t arg[7];
+	acpi_object_t result;
+} acpi_memo_t;
+
+typedef struct acpi_ir_t
+{
+	size_t count;			// in instructions
+	size_t stack_size;		// deepest the operand stack gets, in objects
+	acpi_irop_t *code;
+
+	uint8_t argc;
+	uint8_t local_count;		// highest LocalX used, plus one, see acpi_compile_slots()
+	uint8_t arg_count;		// highest ArgX used, plus one, at least argc
+	int pure;			// the result only depends on the arguments, see acpi_compile_pure()
+	acpi_memo_t *memo;		// for pure methods, allocated on the first result
+	size_t memo_next;		// entry to replace next
+	struct acpi_mutex_t *mutex;	// for Serialized methods, held while a frame runs it
+
+#ifdef ACPI_JIT
+	void *jit;			// native code, once the method is hot
+	size_t jit_runs;
+	int jit_failed;			// 1 when the method doesn't qualify for the JIT
+#endif
+} acpi_ir_t;
+
+typedef struct acpi_ir_frame_t
+{
+	acpi_ir_t *ir;
+	struct acpi_state_t *state;
+	size_t ip;			// where to continue after a call returns
+	size_t sp;			// operand stack depth at the call, the result goes here
+	size_t base;			// first operand stack slot of this frame
+	struct acpi_mutex_t *mutex;	// of a Serialized method, while the frame holds it
+} acpi_ir_frame_t;
+
+typedef int (*acpi_native_method_t)(struct acpi_state_t *, acpi_object_t *);
+
+#define ACPI_FOREVER			0xFFFF	// Acquire() and Wait() timeout that never runs out
+
+// AML Mutex, apart from its namespace entry because entries get copied
+typedef struct acpi_mutex_t
+{
+	struct acpi_context_t *owner;	// NULL when free, see acpi_acquire_mutex()
+	size_t depth;			// Acquire()s by the owner not released yet
+	uint8_t sync_level;
+	struct acpi_mutex_t *next;	// held by the same owner, acquired before this
+
+	uint32_t sequence;		// changes on every release, for acpi_wait()
+	uint32_t waiters;
+} acpi_mutex_t;
+
+// AML Event, apart from its namespace entry for the same reason
+typedef struct acpi_event_t
+{
+	uint32_t count;			// Signal()s no Wait() consumed yet
+	uint32_t sequence;		// changes on every Signal(), for acpi_wait()
+	uint32_t waiters;
+} acpi_event_t;
 
 typedef struct acpi_handle_t
 {
 	char path[ACPI_MAX_NAME];	// full path of object
 	int type;
-	void *pointer;			// valid for scopes, methods, etc.
+	void *pointer;			// valid for scopes, methods, etc., and Name() packages not decoded yet
 	size_t size;			// valid for scopes, methods, etc.
 
 	char alias[ACPI_MAX_NAME];	// for Alias() only
@@ -223,6 +399,12 @@ typedef struct acpi_handle_t
 	char field_opregion[ACPI_MAX_NAME];	// for Fields only
 
 	uint8_t method_flags;		// for Methods only, includes ARG_COUNT in lowest three bits
+	acpi_ir_t *method_ir;		// for Methods only, compiled on first execution
+	int method_ir_failed;		// for Methods only, 1 when the method must run from AML
+	acpi_native_method_t method_native;	// for Methods only, when aml2c translated it to C
+#ifdef ACPI_BUDGET
+	struct acpi_budget_t *method_budget;	// for Methods only, replaces acpi_budget when the OS calls it
+#endif
 
 	uint64_t indexfield_offset;	// for IndexFields, in bits
 	char indexfield_index[ACPI_MAX_NAME];	// for IndexFields
@@ -230,42 +412,175 @@ typedef struct acpi_handle_t
 	uint8_t indexfield_flags;	// for IndexFields
 	uint8_t indexfield_size;	// for IndexFields
 
-	acpi_lock_t mutex;		// for Mutex
+	acpi_mutex_t *mutex;		// for Mutex, and Serialized methods
+	acpi_event_t *event;		// for Event
 
 	uint8_t cpu_id;			// for Processor
 
+	uint64_t device_status;		// for Devices only, cached _STA
+	int device_status_valid;	// for Devices only, 1 when the above is valid
+
 	char buffer[ACPI_MAX_NAME];		// for Buffer field
 	uint64_t buffer_offset;		// for Buffer field, in bits
 	uint64_t buffer_size;		// for Buffer field, in bits
+
+	size_t index;			// in the namespace, see ACPI_HANDLE()
 } acpi_handle_t;
 
-typedef struct acpi_condition_t
+// Handle at an index of the namespace; the blocks never move, so a handle
+// stays valid while other threads add objects
+#define ACPI_HANDLE(index)		(&acpi_namespace[(index) / ACPI_MAX_NAMESPACE_ENTRIES][(index) % ACPI_MAX_NAMESPACE_ENTRIES])
+
+typedef struct acpi_block_t
 {
-	acpi_object_t predicate;
-	size_t predicate_size;
-	size_t pkgsize;
-	size_t end;
-} acpi_condition_t;
+	int type;			// ACPI_BLOCK_*
+	size_t predicate;		// for While, where the predicate starts
+	size_t end;			// first byte after the block
+} acpi_block_t;
 
 typedef struct acpi_state_t
 {
 	char name[ACPI_MAX_NAME];
 	acpi_object_t arg[7];
 	acpi_object_t local[8];
+	uint8_t arg_count;		// ArgX that may hold objects, see acpi_pop_state()
+	uint8_t local_count;		// LocalX that may hold objects
+	size_t scope;			// index in acpi_namespace of the method, ACPI_NO_SCOPE until known
 
-	// for looping
-	int status;
-	acpi_object_t loop_predicate;
-	size_t loop_predicate_size;
-	size_t loop_pkgsize;
-	size_t loop_start;
-	size_t loop_end;
-
-	// conditional
-	int condition_level;
-	acpi_condition_t condition[16];
+	// If, Else and While being executed, innermost last
+	int block_level;
+	acpi_block_t block[ACPI_MAX_BLOCKS];
 } acpi_state_t;
 
+#define ACPI_MAX_FRAMES			64	// pooled method states, deeper calls use acpi_malloc()
+#define ACPI_NAME_CACHE_SIZE		256	// power of two
+
+#define ACPI_NO_SCOPE			((size_t)-1)	// the scope isn't a namespace object, names aren't cached
+
+// Resolved NameStrings, keyed by where they are in the AML and the scope
+typedef struct acpi_name_cache_t
+{
+	uint8_t *aml;
+	size_t scope;			// acpi_context_t.scope when cached
+	size_t generation;		// acpi_namespace_generation when cached
+	size_t handle;			// index in acpi_namespace
+	size_t size;			// size of the NameString in bytes
+} acpi_name_cache_t;
+
+#define ACPI_WOULD_BLOCK		1	// status of a method that stopped to wait, see acpi_start_method()
+
+#define ACPI_WAIT_SLEEP			1	// Sleep(), time is in milliseconds
+#define ACPI_WAIT_MUTEX			2	// Acquire() of a mutex another context holds, time is the acpi_timer() deadline or 0
+#define ACPI_WAIT_EVENT			3	// Wait() for acpi_signal_event(), time as for ACPI_WAIT_MUTEX
+
+// What a stopped method waits for before acpi_resume_method()
+typedef struct acpi_wait_t
+{
+	int type;			// ACPI_WAIT_*
+	uint64_t time;
+	acpi_mutex_t *mutex;		// ACPI_WAIT_MUTEX, acpi_resume_method() tries it again
+	acpi_event_t *event;		// ACPI_WAIT_EVENT, likewise
+} acpi_wait_t;
+
+#define ACPI_ABORTED			2	// status of a method that ran out of its budget, with ACPI_BUDGET
+
+// Limits on a method the OS calls, including everything it calls in turn,
+// with ACPI_BUDGET; zero means no limit
+typedef struct acpi_budget_t
+{
+	uint64_t opcodes;		// statements and IR instructions the call may execute
+	uint64_t time;			// wall-clock time it may take, in 100 ns units, see acpi_timer()
+	size_t yield_interval;		// loop iterations between calls to yield()
+	void (*yield)();		// lets the OS run something else while firmware loops
+} acpi_budget_t;
+
+// What belongs to one call from the OS rather than to its context, set
+// aside while the method acpi_start_method() started is stopped, so that
+// the OS can call other methods meanwhile, see acpi_swap_call()
+typedef struct acpi_call_t
+{
+	uint8_t *arena;
+	size_t arena_top;
+	int arena_depth;
+
+	uint8_t sync_level;
+	acpi_mutex_t *mutexes;
+
+#ifdef ACPI_BUDGET
+	acpi_budget_t *budget;
+	uint64_t opcodes_left;
+	uint64_t deadline;
+	size_t branches;
+#endif
+} acpi_call_t;
+
+// Everything that changes while AML runs, one per thread or CPU that calls
+// into lai, see acpi_context()
+typedef struct acpi_context_t
+{
+	char path[ACPI_MAX_NAME];	// scope that relative names resolve from
+	size_t scope;			// index in acpi_namespace of the method path names, or ACPI_NO_SCOPE
+
+	acpi_state_t *state_pool;	// see acpi_push_state()
+	size_t state_count;
+
+	acpi_ir_frame_t *ir_frames;	// see acpi_ir_push_frame()
+	acpi_object_t *ir_stack;	// operand stack, shared by all frames
+	size_t ir_frame_count;
+
+	uint8_t *arena;			// see acpi_alloc_counted()
+	size_t arena_top;
+	int arena_depth;
+
+	acpi_name_cache_t *name_cache;	// allocated on the first lookup
+
+	size_t compile_methods[ACPI_INLINE_DEPTH];	// namespace indices of the methods being compiled
+	size_t compile_nesting;
+
+	int resumable;			// the next compiled method may stop, see acpi_start_method()
+	acpi_wait_t wait;		// what the stopped method waits for
+
+	uint8_t sync_level;		// of the last mutex acquired, see acpi_acquire_mutex()
+	acpi_mutex_t *mutexes;		// held, last acquired first
+
+#ifdef ACPI_BUDGET
+	acpi_budget_t *budget;		// of the method the OS called, see acpi_budget_start()
+	uint64_t opcodes_left;		// 0 once the call is aborted
+	uint64_t deadline;		// acpi_timer() value, 0 for none
+	size_t branches;		// loop iterations so far
+#endif
+
+	acpi_call_t stopped;		// of the stopped method, or the spare arena when there is none
+
+#ifdef ACPI_JIT_VERIFY
+	int jit_verifying;
+#endif
+} acpi_context_t;
+
+// With ACPI_THREADS, the OS keeps a context from acpi_create_context() for
+// every thread that evaluates AML, and a lock serializes changes to the
+// namespace; otherwise there is one context and nothing to lock
+#ifdef ACPI_THREADS
+#define acpi_context()			acpi_get_context()
+#define ACPI_LOCK(lock)			acpi_acquire_lock(lock)
+#define ACPI_UNLOCK(lock)		acpi_release_lock(lock)
+#else
+#define acpi_context()			(&acpi_default_context)
+#define ACPI_LOCK(lock)
+#define ACPI_UNLOCK(lock)
+#endif
+
+// Opcode dispatch tables, indexed by opcode byte
+// eval evaluates an opcode as an operand, exec executes it as a statement
+typedef size_t (*acpi_eval_handler_t)(acpi_object_t *, acpi_state_t *, void *);
+typedef size_t (*acpi_exec_handler_t)(void *, acpi_state_t *);
+
+typedef struct acpi_opcode_t
+{
+	acpi_eval_handler_t eval;
+	acpi_exec_handler_t exec;
+} acpi_opcode_t;
+
 typedef struct acpi_resource_t
 {
 	uint8_t type;
@@ -297,11 +612,22 @@ typedef struct acpi_large_irq_t
 	uint32_t irq;
 }__attribute__((packed)) acpi_large_irq_t;
 
-acpi_fadt_t *acpi_fadt;
-acpi_aml_t *acpi_dsdt;
-acpi_handle_t *acpi_namespace;
-extern char acpins_path[];
-size_t acpi_namespace_entries;
+extern acpi_fadt_t *acpi_fadt;
+extern acpi_aml_t *acpi_dsdt;
+extern acpi_handle_t **acpi_namespace;
+extern size_t acpi_namespace_generation;
+extern acpi_lock_t acpi_namespace_lock;
+#ifndef ACPI_THREADS
+extern acpi_context_t acpi_default_context;
+#endif
+extern char acpi_emulated_os[];
+extern uint64_t acpi_implemented_version;
+#ifdef ACPI_BUDGET
+extern acpi_budget_t acpi_budget;
+#endif
+extern acpi_opcode_t acpi_opcodes[];
+extern acpi_opcode_t acpi_extopcodes[];
+extern size_t acpi_namespace_entries;
 
 // OS-specific functions
 void *acpi_scan(char *, size_t);
@@ -325,13 +651,27 @@ uint32_t acpi_pci_read(uint8_t, uint8_t, uint8_t, uint16_t);
 uint8_t acpi_inb(uint16_t);
 uint16_t acpi_inw(uint16_t);
 uint32_t acpi_ind(uint16_t);
-void acpi_sleep(uint64_t);
+void acpi_sleep(uint64_t);		// milliseconds, 0 only gives up the CPU
+uint64_t acpi_timer();			// monotonic, in 100 ns units, see acpi_pm_timer()
+#ifdef ACPI_JIT
+void *acpi_jit_map(size_t);		// writable and executable memory, NULL to keep interpreting
+#endif
+#ifdef ACPI_THREADS
+acpi_context_t *acpi_get_context();	// context of the running thread
+void acpi_acquire_lock(acpi_lock_t *);
+void acpi_release_lock(acpi_lock_t *);
+void acpi_wait(volatile uint32_t *, uint32_t, uint64_t);	// sleeps while the word holds the value, at most the time in 100 ns units
+void acpi_wake(volatile uint32_t *);	// wakes everything acpi_wait()ing on the word
+#endif
 
 // The remaining of these functions are OS independent!
 // ACPI namespace functions
 void acpins_increment_namespace();
+void acpins_grow_namespace();
 size_t acpins_resolve_path(char *, uint8_t *);
 void acpi_create_namespace(void *);
+void acpi_load_namespace(acpi_handle_t *, size_t, uint8_t *, size_t);
+acpi_context_t *acpi_create_context();
 int acpi_is_name(char);
 size_t acpi_eval_integer(uint8_t *, uint64_t *);
 size_t acpi_parse_pkgsize(uint8_t *, size_t *);
@@ -346,8 +686,12 @@ size_t acpins_create_thermalzone(void *);
 size_t acpins_create_name(void *);
 size_t acpins_create_alias(void *);
 size_t acpins_create_mutex(void *);
+size_t acpins_create_event(void *);
 size_t acpins_create_indexfield(void *);
-size_t acpins_create_package(acpi_object_t *, void *);
+size_t acpins_create_package(acpi_object_t *, acpi_state_t *, void *);
+acpi_object_t *acpins_load_object(acpi_handle_t *);
+void acpins_read_name(acpi_object_t *, acpi_handle_t *);
+void acpins_write_name(acpi_handle_t *, acpi_object_t *);
 size_t acpins_create_processor(void *);
 size_t acpins_create_bytefield(void *);
 size_t acpins_create_wordfield(void *);
@@ -356,17 +700,43 @@ size_t acpins_create_qwordfield(void *);
 acpi_handle_t *acpins_resolve(char *);
 acpi_handle_t *acpins_get_device(size_t);
 acpi_handle_t *acpins_get_deviceid(size_t, acpi_object_t *);
+acpi_handle_t *acpins_get_parent_device(acpi_handle_t *);
+uint64_t acpins_get_status(acpi_handle_t *);
+void acpi_init_devices();
 void acpi_eisaid(acpi_object_t *, char *);
 size_t acpi_read_resource(acpi_handle_t *, acpi_resource_t *);
 
 // ACPI Control Methods
 size_t acpi_eval_object(acpi_object_t *, acpi_state_t *, void *);
+size_t acpi_eval_operands(acpi_state_t *, uint8_t *, acpi_object_t *, acpi_object_t *);
+size_t acpi_eval_result(acpi_object_t *, acpi_state_t *, uint8_t *, uint64_t);
 int acpi_eval(acpi_object_t *, char *);
 void acpi_copy_object(acpi_object_t *, acpi_object_t *);
+void acpi_free_object(acpi_object_t *);
+void acpi_replace_object(acpi_object_t *, acpi_object_t *);
+void acpi_unshare_object(acpi_object_t *);
+void *acpi_alloc_counted(size_t);
+void *acpi_counted_data(acpi_object_t *);
+void acpi_persist_object(acpi_object_t *);
+void acpi_write_entry(acpi_object_t *, size_t, acpi_object_t *);
+void acpi_arena_enter();
+void acpi_arena_leave(acpi_state_t *, acpi_object_t *);
 size_t acpi_write_object(void *, acpi_object_t *, acpi_state_t *);
+acpi_object_t *acpi_exec_holder(uint8_t *, acpi_state_t *, size_t *);
 acpi_handle_t *acpi_exec_resolve(char *);
+acpi_handle_t *acpi_exec_resolve_name(uint8_t *, size_t *);
 int acpi_exec_method(acpi_state_t *, acpi_object_t *);
+int acpi_start_method(acpi_state_t *, acpi_object_t *);
+int acpi_resume_method(acpi_object_t *);
+void acpi_swap_call();
+#ifdef ACPI_BUDGET
+void acpi_budget_start(acpi_handle_t *);
+int acpi_budget_branch(uint64_t);
+#endif
+uint32_t acpi_exec_osi(char *);
 size_t acpi_methodinvoke(void *, acpi_state_t *, acpi_object_t *);
+acpi_state_t *acpi_push_state(char *);
+void acpi_pop_state(acpi_state_t *);
 void acpi_read_opregion(acpi_object_t *, acpi_handle_t *);
 void acpi_write_opregion(acpi_handle_t *, acpi_object_t *);
 size_t acpi_exec_store(void *, acpi_state_t *);
@@ -383,6 +753,19 @@ size_t acpi_exec_xor(void *, acpi_state_t *);
 size_t acpi_exec_shl(void *, acpi_state_t *);
 size_t acpi_exec_shr(void *, acpi_state_t *);
 size_t acpi_exec_sleep(void *, acpi_state_t *);
+size_t acpi_exec_stall(void *, acpi_state_t *);
+size_t acpi_exec_acquire(void *, acpi_state_t *);
+size_t acpi_eval_acquire(acpi_object_t *, acpi_state_t *, void *);
+size_t acpi_exec_release(void *, acpi_state_t *);
+size_t acpi_exec_signal(void *, acpi_state_t *);
+size_t acpi_exec_wait(void *, acpi_state_t *);
+size_t acpi_eval_wait(acpi_object_t *, acpi_state_t *, void *);
+size_t acpi_exec_reset(void *, acpi_state_t *);
+size_t acpi_eval_timer(acpi_object_t *, acpi_state_t *, void *);
+size_t acpi_exec_invoke(void *, acpi_state_t *);
+size_t acpi_exec_nop(void *, acpi_state_t *);
+acpi_block_t *acpi_exec_push_block(acpi_state_t *, int, size_t, size_t);
+size_t acpi_exec_loop(acpi_state_t *);
 uint16_t acpi_bswap16(uint16_t);
 uint32_t acpi_bswap32(uint32_t);
 uint8_t acpi_char_to_hex(char);
@@ -392,9 +775,42 @@ void acpi_write_buffer(acpi_handle_t *, acpi_object_t *);
 size_t acpi_exec_bytefield(void *, acpi_state_t *);
 size_t acpi_exec_wordfield(void *, acpi_state_t *);
 size_t acpi_exec_dwordfield(void *, acpi_state_t *);
+size_t acpi_exec_qwordfield(void *, acpi_state_t *);
+
+// Method Compiler and IR
+acpi_ir_t *acpi_compile_method(acpi_handle_t *);
+acpi_ir_t *acpi_compile_cached(acpi_handle_t *);
+int acpi_ir_memo_lookup(acpi_ir_t *, acpi_state_t *, acpi_object_t *);
+void acpi_ir_memo_store(acpi_ir_t *, acpi_state_t *, acpi_object_t *);
+acpi_handle_t *acpi_ir_resolve(acpi_irop_t *);
+void acpi_ir_read_name(acpi_object_t *, acpi_irop_t *);
+void acpi_ir_write_name(acpi_irop_t *, acpi_object_t *);
+void acpi_ir_store_index(acpi_irop_t *, acpi_state_t *, uint64_t, acpi_object_t *);
+void acpi_ir_index(acpi_object_t *, uint64_t);
+void acpi_ir_sizeof(acpi_object_t *);
+void acpi_ir_define_name(acpi_irop_t *, acpi_object_t *);
+void acpi_ir_create_field(acpi_irop_t *, acpi_state_t *);
+acpi_mutex_t *acpi_ir_mutex(acpi_irop_t *);
+acpi_event_t *acpi_ir_event(acpi_irop_t *);
+int acpi_ir_exec(acpi_ir_t *, acpi_state_t *, acpi_object_t *);
+int acpi_ir_resume(acpi_object_t *);
+#ifdef ACPI_JIT
+int acpi_jit_exec(acpi_ir_t *, acpi_state_t *, acpi_object_t *);
+#endif
 
 // Generic Functions
 int acpi_enter_sleep(uint8_t);
+uint64_t acpi_pm_timer();
+void acpi_stall(uint64_t);
+int acpi_acquire_mutex(acpi_mutex_t *, uint16_t);
+int acpi_try_mutex(acpi_mutex_t *);
+void acpi_release_mutex(acpi_mutex_t *);
+void acpi_release_method_mutex(acpi_mutex_t *);
+void acpi_release_mutexes();
+acpi_event_t *acpi_get_event(char *);
+void acpi_signal_event(acpi_event_t *);
+int acpi_wait_event(acpi_event_t *, uint64_t);
+void acpi_reset_event(acpi_event_t *);
 int acpi_pci_route(acpi_resource_t *, uint8_t, uint8_t, uint8_t);
 
 
@@ -15,6 +15,8 @@
 #include <pci.h>
 #include <timer.h>
 
+uint64_t acpi_pm_timer();
+
 // Any OS using lai must provide implementations of the following functions
 
 void *acpi_memcpy(void *dest, const void *src, size_t count)
@@ -131,9 +133,22 @@ uint32_t acpi_pci_read(uint8_t bus, uint8_t slot, uint8_t function, uint16_t off
 
 void acpi_sleep(uint64_t time)
 {
+	// nothing else runs while lux sets up ACPI, so giving up the CPU
+	// only needs to ease off the bus
+	if(!time)
+	{
+		asm volatile ("pause");
+		return;
+	}
+
 	timer_sleep(time);
 }
 
+uint64_t acpi_timer()
+{
+	return acpi_pm_timer();
+}
+
 
 
 
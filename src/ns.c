@@ -15,10 +15,13 @@ size_t acpi_acpins_allocation = 0;
 size_t acpi_acpins_size = 0;
 size_t acpi_acpins_count = 0;
 extern char aml_test[];
-char acpins_path[ACPI_MAX_NAME];
 
-acpi_handle_t *acpi_namespace;
+acpi_fadt_t *acpi_fadt;		// set by the OS before anything needs the hardware
+acpi_aml_t *acpi_dsdt;
+acpi_handle_t **acpi_namespace;		// blocks of ACPI_MAX_NAMESPACE_ENTRIES handles
 size_t acpi_namespace_entries = 0;
+size_t acpi_namespace_generation = 1;	// changes whenever an object is added
+acpi_lock_t acpi_namespace_lock;	// held by threads that add or decode objects at run time
 
 acpi_state_t acpins_state;	// not really used
 
@@ -52,7 +55,7 @@ size_t acpins_resolve_path(char *fullpath, uint8_t *path)
 			return name_size;
 	}
 
-	acpi_strcpy(fullpath, acpins_path);
+	acpi_strcpy(fullpath, acpi_context()->path);
 	fullpath[acpi_strlen(fullpath)] = '.';
 
 start:
@@ -112,8 +115,40 @@ start:
 void acpins_increment_namespace()
 {
 	acpi_namespace_entries++;
+	acpi_namespace_generation++;
+
+	// the next object is filled in before it's counted, so it needs room
 	if((acpi_namespace_entries % ACPI_MAX_NAMESPACE_ENTRIES) == 0)
-		acpi_namespace = acpi_realloc(acpi_namespace, (acpi_namespace_entries + ACPI_MAX_NAMESPACE_ENTRIES + 1) * sizeof(acpi_handle_t));
+		acpins_grow_namespace();
+}
+
+// acpins_grow_namespace(): Adds a block to the namespace, starting at acpi_namespace_entries
+// Param:	Nothing
+// Return:	Nothing
+
+void acpins_grow_namespace()
+{
+	size_t block = acpi_namespace_entries / ACPI_MAX_NAMESPACE_ENTRIES;
+	size_t i;
+
+	// only the list of blocks moves, never the handles in them
+	acpi_handle_t **blocks = acpi_malloc((block + 1) * sizeof(acpi_handle_t*));
+	if(block)
+	{
+		acpi_memcpy(blocks, acpi_namespace, block * sizeof(acpi_handle_t*));
+#ifndef ACPI_THREADS
+		// other threads' methods may still be reading the old list, so
+		// with ACPI_THREADS it's left to them
+		acpi_free(acpi_namespace);
+#endif
+	}
+
+	// some fields are only valid when zero-initialized
+	blocks[block] = acpi_calloc(sizeof(acpi_handle_t), ACPI_MAX_NAMESPACE_ENTRIES);
+	for(i = 0; i < ACPI_MAX_NAMESPACE_ENTRIES; i++)
+		blocks[block][i].index = block * ACPI_MAX_NAMESPACE_ENTRIES + i;
+
+	acpi_namespace = blocks;
 }
 
 // acpi_create_namespace(): Initializes the AML interpreter and creates the ACPI namespace
@@ -122,12 +157,14 @@ void acpins_increment_namespace()
 
 void acpi_create_namespace(void *dsdt)
 {
-	acpi_memset(acpins_path, 0, ACPI_MAX_NAME);
-	acpins_path[0] = ROOT_CHAR;
+	acpi_memset(acpi_context()->path, 0, ACPI_MAX_NAME);
+	acpi_context()->path[0] = ROOT_CHAR;
+	acpi_context()->scope = ACPI_NO_SCOPE;
 
 	acpi_acpins_code = acpi_malloc(CODE_WINDOW);
 	acpi_acpins_allocation = CODE_WINDOW;
-	acpi_namespace = acpi_calloc(sizeof(acpi_handle_t), ACPI_MAX_NAMESPACE_ENTRIES);
+	acpi_namespace_entries = 0;
+	acpins_grow_namespace();
 
 	//acpins_load_table(aml_test);	// custom AML table just for testing
 
@@ -156,17 +193,17 @@ void acpi_create_namespace(void *dsdt)
 	}
 
 	// create the OS-defined objects first
-	acpi_namespace[0].type = ACPI_NAMESPACE_METHOD;
-	acpi_strcpy(acpi_namespace[0].path, "\\._OSI");
-	acpi_namespace[0].method_flags = 0x01;
+	ACPI_HANDLE(0)->type = ACPI_NAMESPACE_METHOD;
+	acpi_strcpy(ACPI_HANDLE(0)->path, "\\._OSI");
+	ACPI_HANDLE(0)->method_flags = 0x01;
 
-	acpi_namespace[1].type = ACPI_NAMESPACE_METHOD;
-	acpi_strcpy(acpi_namespace[1].path, "\\._OS_");
-	acpi_namespace[1].method_flags = 0x00;
+	ACPI_HANDLE(1)->type = ACPI_NAMESPACE_METHOD;
+	acpi_strcpy(ACPI_HANDLE(1)->path, "\\._OS_");
+	ACPI_HANDLE(1)->method_flags = 0x00;
 
-	acpi_namespace[2].type = ACPI_NAMESPACE_METHOD;
-	acpi_strcpy(acpi_namespace[2].path, "\\._REV");
-	acpi_namespace[2].method_flags = 0x00;
+	ACPI_HANDLE(2)->type = ACPI_NAMESPACE_METHOD;
+	acpi_strcpy(ACPI_HANDLE(2)->path, "\\._REV");
+	ACPI_HANDLE(2)->method_flags = 0x00;
 
 	acpi_namespace_entries = 3;
 
@@ -177,6 +214,40 @@ void acpi_create_namespace(void *dsdt)
 	acpi_printf("acpi: ACPI namespace created, total of %d predefined objects.\n", acpi_namespace_entries);
 }
 
+// acpi_load_namespace(): Installs a namespace built ahead of time, instead of acpi_create_namespace()
+// Param:	acpi_handle_t *namespace - objects, as generated by aml2c
+// Param:	size_t count - number of objects
+// Param:	uint8_t *aml - AML of all the tables, which the objects point into
+// Param:	size_t size - size of AML in bytes
+// Return:	Nothing
+
+void acpi_load_namespace(acpi_handle_t *namespace, size_t count, uint8_t *aml, size_t size)
+{
+	acpi_handle_t *handle;
+
+	acpi_memset(acpi_context()->path, 0, ACPI_MAX_NAME);
+	acpi_context()->path[0] = ROOT_CHAR;
+	acpi_context()->scope = ACPI_NO_SCOPE;
+
+	acpi_acpins_code = aml;
+	acpi_acpins_size = size;
+	acpi_acpins_allocation = size;
+
+	// the namespace still grows at run time, so it goes on the heap in
+	// blocks, like the one acpi_create_namespace() builds
+	acpi_namespace_entries = 0;
+	acpins_grow_namespace();
+	while(acpi_namespace_entries < count)
+	{
+		handle = ACPI_HANDLE(acpi_namespace_entries);
+		acpi_memcpy(handle, &namespace[acpi_namespace_entries], sizeof(acpi_handle_t));
+		handle->index = acpi_namespace_entries;
+		acpins_increment_namespace();
+	}
+
+	acpi_printf("acpi: ACPI namespace loaded, total of %d predefined objects.\n", (int)acpi_namespace_entries);
+}
+
 // acpins_load_table(): Loads an AML table
 // Param:	void *ptr - pointer to table
 // Return:	Nothing
@@ -279,6 +350,9 @@ void acpins_register_scope(uint8_t *data, size_t size)
 			case MUTEX:
 				count += acpins_create_mutex(&data[count]);
 				break;
+			case EVENT:
+				count += acpins_create_event(&data[count]);
+				break;
 			case OPREGION:
 				count += acpins_create_opregion(&data[count]);
 				break;
@@ -342,21 +416,23 @@ size_t acpins_create_scope(void *data)
 
 	// register the scope
 	scope += pkgsize + 1;
-	size_t name_length = acpins_resolve_path(acpi_namespace[acpi_namespace_entries].path, scope);
+	size_t name_length = acpins_resolve_path(ACPI_HANDLE(acpi_namespace_entries)->path, scope);
 
-	//acpi_printf("acpi: scope %s, size %d bytes\n", acpi_namespace[acpi_namespace_entries].path, size);
+	//acpi_printf("acpi: scope %s, size %d bytes\n", ACPI_HANDLE(acpi_namespace_entries)->path, size);
 
 	// store the new current path
 	char current_path[ACPI_MAX_NAME];
-	acpi_strcpy(current_path, acpins_path);
+	acpi_strcpy(current_path, acpi_context()->path);
 
-	// and update the path
-	acpi_strcpy(acpins_path, acpi_namespace[acpi_namespace_entries].path);
+	// and update the path, which names no method
+	acpi_strcpy(acpi_context()->path, ACPI_HANDLE(acpi_namespace_entries)->path);
+	size_t current_scope = acpi_context()->scope;
+	acpi_context()->scope = ACPI_NO_SCOPE;
 
 	// put the scope in the namespace
-	acpi_namespace[acpi_namespace_entries].type = ACPI_NAMESPACE_SCOPE;
-	acpi_namespace[acpi_namespace_entries].size = size - pkgsize - name_length;
-	acpi_namespace[acpi_namespace_entries].pointer = (void*)(data + 1 + pkgsize + name_length);
+	ACPI_HANDLE(acpi_namespace_entries)->type = ACPI_NAMESPACE_SCOPE;
+	ACPI_HANDLE(acpi_namespace_entries)->size = size - pkgsize - name_length;
+	ACPI_HANDLE(acpi_namespace_entries)->pointer = (void*)(data + 1 + pkgsize + name_length);
 
 	acpins_increment_namespace();
 
@@ -364,7 +440,8 @@ size_t acpins_create_scope(void *data)
 	acpins_register_scope((uint8_t*)data + 1 + pkgsize + name_length, size - pkgsize - name_length);
 
 	// finally restore the original path
-	acpi_strcpy(acpins_path, current_path);
+	acpi_strcpy(acpi_context()->path, current_path);
+	acpi_context()->scope = current_scope;
 	return size + 1;
 }
 
@@ -378,7 +455,7 @@ size_t acpins_create_opregion(void *data)
 	opregion += 2;		// skip EXTOP_PREFIX and OPREGION opcodes
 
 	// create a namespace object for the opregion
-	size_t name_length = acpins_resolve_path(acpi_namespace[acpi_namespace_entries].path, opregion);
+	size_t name_length = acpins_resolve_path(ACPI_HANDLE(acpi_namespace_entries)->path, opregion);
 
 	opregion = (uint8_t*)data;
 
@@ -387,7 +464,7 @@ size_t acpins_create_opregion(void *data)
 	uint64_t integer;
 	size_t integer_size;
 
-	acpi_namespace[acpi_namespace_entries].op_address_space = opregion[size];
+	ACPI_HANDLE(acpi_namespace_entries)->op_address_space = opregion[size];
 	size++;
 
 	integer_size = acpi_eval_object(&object, &acpins_state, &opregion[size]);
@@ -397,7 +474,7 @@ size_t acpins_create_opregion(void *data)
 		acpi_panic("acpi: undefined opcode, sequence: %xb %xb %xb %xb\n", opregion[size], opregion[size+1], opregion[size+2], opregion[size+3]);
 	}
 
-	acpi_namespace[acpi_namespace_entries].op_base = integer;
+	ACPI_HANDLE(acpi_namespace_entries)->op_base = integer;
 	size += integer_size;
 
 	integer_size = acpi_eval_integer(&opregion[size], &integer);
@@ -406,30 +483,30 @@ size_t acpins_create_opregion(void *data)
 		acpi_panic("acpi: undefined opcode, sequence: %xb %xb %xb %xb\n", opregion[size], opregion[size+1], opregion[size+2], opregion[size+3]);
 	}
 
-	acpi_namespace[acpi_namespace_entries].op_length = integer;
+	ACPI_HANDLE(acpi_namespace_entries)->op_length = integer;
 	size += integer_size;
 
-	/*acpi_printf("acpi: OpRegion %s: ", acpi_namespace[acpi_namespace_entries].path);
-	switch(acpi_namespace[acpi_namespace_entries].op_address_space)
+	/*acpi_printf("acpi: OpRegion %s: ", ACPI_HANDLE(acpi_namespace_entries)->path);
+	switch(ACPI_HANDLE(acpi_namespace_entries)->op_address_space)
 	{
 	case OPREGION_MEMORY:
-		acpi_printf("MMIO: 0x%xq-0x%xq\n", acpi_namespace[acpi_namespace_entries].op_base, acpi_namespace[acpi_namespace_entries].op_base + acpi_namespace[acpi_namespace_entries].op_length);
+		acpi_printf("MMIO: 0x%xq-0x%xq\n", ACPI_HANDLE(acpi_namespace_entries)->op_base, ACPI_HANDLE(acpi_namespace_entries)->op_base + ACPI_HANDLE(acpi_namespace_entries)->op_length);
 		break;
 	case OPREGION_IO:
-		acpi_printf("I/O port: 0x%xw-0x%xw\n", (uint16_t)(acpi_namespace[acpi_namespace_entries].op_base), (uint16_t)(acpi_namespace[acpi_namespace_entries].op_base + acpi_namespace[acpi_namespace_entries].op_length));
+		acpi_printf("I/O port: 0x%xw-0x%xw\n", (uint16_t)(ACPI_HANDLE(acpi_namespace_entries)->op_base), (uint16_t)(ACPI_HANDLE(acpi_namespace_entries)->op_base + ACPI_HANDLE(acpi_namespace_entries)->op_length));
 		break;
 	case OPREGION_PCI:
-		acpi_printf("PCI config: 0x%xw-0x%xw\n", (uint16_t)(acpi_namespace[acpi_namespace_entries].op_base), (uint16_t)(acpi_namespace[acpi_namespace_entries].op_base + acpi_namespace[acpi_namespace_entries].op_length));
+		acpi_printf("PCI config: 0x%xw-0x%xw\n", (uint16_t)(ACPI_HANDLE(acpi_namespace_entries)->op_base), (uint16_t)(ACPI_HANDLE(acpi_namespace_entries)->op_base + ACPI_HANDLE(acpi_namespace_entries)->op_length));
 		break;
 	case OPREGION_EC:
-		acpi_printf("embedded controller: 0x%xb-0x%xb\n", (uint8_t)(acpi_namespace[acpi_namespace_entries].op_base), (uint8_t)(acpi_namespace[acpi_namespace_entries].op_base + acpi_namespace[acpi_namespace_entries].op_length));
+		acpi_printf("embedded controller: 0x%xb-0x%xb\n", (uint8_t)(ACPI_HANDLE(acpi_namespace_entries)->op_base), (uint8_t)(ACPI_HANDLE(acpi_namespace_entries)->op_base + ACPI_HANDLE(acpi_namespace_entries)->op_length));
 		break;
 	case OPREGION_CMOS:
-		acpi_printf("CMOS RAM: 0x%xb-0x%xb\n", (uint8_t)(acpi_namespace[acpi_namespace_entries].op_base), (uint8_t)(acpi_namespace[acpi_namespace_entries].op_base + acpi_namespace[acpi_namespace_entries].op_length));
+		acpi_printf("CMOS RAM: 0x%xb-0x%xb\n", (uint8_t)(ACPI_HANDLE(acpi_namespace_entries)->op_base), (uint8_t)(ACPI_HANDLE(acpi_namespace_entries)->op_base + ACPI_HANDLE(acpi_namespace_entries)->op_length));
 		break;
 
 	default:
-		acpi_panic("unsupported address space ID 0x%xb\n", acpi_namespace[acpi_namespace_entries].op_address_space);
+		acpi_panic("unsupported address space ID 0x%xb\n", ACPI_HANDLE(acpi_namespace_entries)->op_address_space);
 	}*/
 
 	acpins_increment_namespace();
@@ -552,18 +629,18 @@ size_t acpins_create_field(void *data)
 			break;
 
 		//acpi_printf("acpi: field %c%c%c%c: size %d bits, at bit offset %d\n", field[0], field[1], field[2], field[3], field[4], current_offset);
-		acpi_namespace[acpi_namespace_entries].type = ACPI_NAMESPACE_FIELD;
-		//acpi_memcpy(acpi_namespace[acpi_namespace_entries].path, acpins_path, acpi_strlen(acpins_path));
+		ACPI_HANDLE(acpi_namespace_entries)->type = ACPI_NAMESPACE_FIELD;
+		//acpi_memcpy(ACPI_HANDLE(acpi_namespace_entries)->path, acpi_context()->path, acpi_strlen(acpi_context()->path));
 
-		name_size = acpins_resolve_path(acpi_namespace[acpi_namespace_entries].path, &field[0]);
+		name_size = acpins_resolve_path(ACPI_HANDLE(acpi_namespace_entries)->path, &field[0]);
 		field += name_size;
 		byte_count += name_size;
 
-		acpi_namespace[acpi_namespace_entries].path[acpi_strlen(acpins_path)] = '.';
-		acpi_strcpy(acpi_namespace[acpi_namespace_entries].field_opregion, opregion->path);
-		acpi_namespace[acpi_namespace_entries].field_flags = field_flags;
-		acpi_namespace[acpi_namespace_entries].field_size = field[0];
-		acpi_namespace[acpi_namespace_entries].field_offset = current_offset;
+		ACPI_HANDLE(acpi_namespace_entries)->path[acpi_strlen(acpi_context()->path)] = '.';
+		acpi_strcpy(ACPI_HANDLE(acpi_namespace_entries)->field_opregion, opregion->path);
+		ACPI_HANDLE(acpi_namespace_entries)->field_flags = field_flags;
+		ACPI_HANDLE(acpi_namespace_entries)->field_size = field[0];
+		ACPI_HANDLE(acpi_namespace_entries)->field_offset = current_offset;
 
 		current_offset += (uint64_t)(field[0]);
 		acpins_increment_namespace();
@@ -589,19 +666,27 @@ size_t acpins_create_method(void *data)
 	method += pkgsize;
 
 	// create a namespace object for the method
-	size_t name_length = acpins_resolve_path(acpi_namespace[acpi_namespace_entries].path, method);
+	size_t name_length = acpins_resolve_path(ACPI_HANDLE(acpi_namespace_entries)->path, method);
 
 	// get the method's flags
 	method = (uint8_t*)data;
 	method += pkgsize + name_length + 1;
 
 	// put the method in the namespace
-	acpi_namespace[acpi_namespace_entries].type = ACPI_NAMESPACE_METHOD;
-	acpi_namespace[acpi_namespace_entries].method_flags = method[0];
-	acpi_namespace[acpi_namespace_entries].pointer = (void*)(method + 1);
-	acpi_namespace[acpi_namespace_entries].size = size - pkgsize - name_length - 1;
+	ACPI_HANDLE(acpi_namespace_entries)->type = ACPI_NAMESPACE_METHOD;
+	ACPI_HANDLE(acpi_namespace_entries)->method_flags = method[0];
+	ACPI_HANDLE(acpi_namespace_entries)->pointer = (void*)(method + 1);
+	ACPI_HANDLE(acpi_namespace_entries)->size = size - pkgsize - name_length - 1;
 
-	/*acpi_printf("acpi: control method %s, flags 0x%xb (argc %d ", acpi_namespace[acpi_namespace_entries].path, method[0], method[0] & METHOD_ARGC_MASK);
+	// only one context at a time runs a Serialized method, like a Mutex
+	// acquired with the method's SyncLevel
+	if(method[0] & METHOD_SERIALIZED)
+	{
+		ACPI_HANDLE(acpi_namespace_entries)->mutex = acpi_calloc(sizeof(acpi_mutex_t), 1);
+		ACPI_HANDLE(acpi_namespace_entries)->mutex->sync_level = method[0] >> METHOD_SYNC_LEVEL_SHIFT;
+	}
+
+	/*acpi_printf("acpi: control method %s, flags 0x%xb (argc %d ", ACPI_HANDLE(acpi_namespace_entries)->path, method[0], method[0] & METHOD_ARGC_MASK);
 	if(method[0] & METHOD_SERIALIZED)
 		acpi_printf("serialized");
 	else
@@ -628,21 +713,23 @@ size_t acpins_create_device(void *data)
 	// register the device
 	device += pkgsize + 2;
 
-	size_t name_length = acpins_resolve_path(acpi_namespace[acpi_namespace_entries].path, device);
+	size_t name_length = acpins_resolve_path(ACPI_HANDLE(acpi_namespace_entries)->path, device);
 
-	//acpi_printf("acpi: device scope %s, size %d bytes\n", acpi_namespace[acpi_namespace_entries].path, size);
+	//acpi_printf("acpi: device scope %s, size %d bytes\n", ACPI_HANDLE(acpi_namespace_entries)->path, size);
 
 	// store the new current path
 	char current_path[ACPI_MAX_NAME];
-	acpi_strcpy(current_path, acpins_path);
+	acpi_strcpy(current_path, acpi_context()->path);
 
-	// and update the path
-	acpi_strcpy(acpins_path, acpi_namespace[acpi_namespace_entries].path);
+	// and update the path, which names no method
+	acpi_strcpy(acpi_context()->path, ACPI_HANDLE(acpi_namespace_entries)->path);
+	size_t current_scope = acpi_context()->scope;
+	acpi_context()->scope = ACPI_NO_SCOPE;
 
 	// put the device scope in the namespace
-	acpi_namespace[acpi_namespace_entries].type = ACPI_NAMESPACE_DEVICE;
-	acpi_namespace[acpi_namespace_entries].size = size - pkgsize - name_length;
-	acpi_namespace[acpi_namespace_entries].pointer = (void*)(data + 2 + pkgsize + name_length);
+	ACPI_HANDLE(acpi_namespace_entries)->type = ACPI_NAMESPACE_DEVICE;
+	ACPI_HANDLE(acpi_namespace_entries)->size = size - pkgsize - name_length;
+	ACPI_HANDLE(acpi_namespace_entries)->pointer = (void*)(data + 2 + pkgsize + name_length);
 
 	acpins_increment_namespace();
 
@@ -650,7 +737,8 @@ size_t acpins_create_device(void *data)
 	acpins_register_scope((uint8_t*)data + 2 + pkgsize + name_length, size - pkgsize - name_length);
 
 	// finally restore the original path
-	acpi_strcpy(acpins_path, current_path);
+	acpi_strcpy(acpi_context()->path, current_path);
+	acpi_context()->scope = current_scope;
 	return size + 2;
 }
 
@@ -669,21 +757,23 @@ size_t acpins_create_thermalzone(void *data)
 	// register the thermalzone
 	thermalzone += pkgsize + 2;
 
-	size_t name_length = acpins_resolve_path(acpi_namespace[acpi_namespace_entries].path, thermalzone);
+	size_t name_length = acpins_resolve_path(ACPI_HANDLE(acpi_namespace_entries)->path, thermalzone);
 
-	//acpi_printf("acpi: thermal zone %s, size %d bytes\n", acpi_namespace[acpi_namespace_entries].path, size);
+	//acpi_printf("acpi: thermal zone %s, size %d bytes\n", ACPI_HANDLE(acpi_namespace_entries)->path, size);
 
 	// store the new current path
 	char current_path[ACPI_MAX_NAME];
-	acpi_strcpy(current_path, acpins_path);
+	acpi_strcpy(current_path, acpi_context()->path);
 
-	// and update the path
-	acpi_strcpy(acpins_path, acpi_namespace[acpi_namespace_entries].path);
+	// and update the path, which names no method
+	acpi_strcpy(acpi_context()->path, ACPI_HANDLE(acpi_namespace_entries)->path);
+	size_t current_scope = acpi_context()->scope;
+	acpi_context()->scope = ACPI_NO_SCOPE;
 
 	// put the device scope in the namespace
-	acpi_namespace[acpi_namespace_entries].type = ACPI_NAMESPACE_THERMALZONE;
-	acpi_namespace[acpi_namespace_entries].size = size - pkgsize - name_length;
-	acpi_namespace[acpi_namespace_entries].pointer = (void*)(data + 2 + pkgsize + name_length);
+	ACPI_HANDLE(acpi_namespace_entries)->type = ACPI_NAMESPACE_THERMALZONE;
+	ACPI_HANDLE(acpi_namespace_entries)->size = size - pkgsize - name_length;
+	ACPI_HANDLE(acpi_namespace_entries)->pointer = (void*)(data + 2 + pkgsize + name_length);
 
 	acpins_increment_namespace();
 
@@ -691,7 +781,8 @@ size_t acpins_create_thermalzone(void *data)
 	acpins_register_scope((uint8_t*)data + 2 + pkgsize + name_length, size - pkgsize - name_length);
 
 	// finally restore the original path
-	acpi_strcpy(acpins_path, current_path);
+	acpi_strcpy(acpi_context()->path, current_path);
+	acpi_context()->scope = current_scope;
 	return size + 2;
 }
 
@@ -706,58 +797,45 @@ size_t acpins_create_name(void *data)
 	name++;			// skip NAME_OP
 
 	// create a namespace object for the name object
-	size_t name_length = acpins_resolve_path(acpi_namespace[acpi_namespace_entries].path, name);
+	size_t name_length = acpins_resolve_path(ACPI_HANDLE(acpi_namespace_entries)->path, name);
 
 	name += name_length;
-	acpi_namespace[acpi_namespace_entries].type = ACPI_NAMESPACE_NAME;
+	ACPI_HANDLE(acpi_namespace_entries)->type = ACPI_NAMESPACE_NAME;
 
 	size_t return_size = name_length + 1;
 
-	if(name[0] == PACKAGE_OP)
+	if(name[0] == PACKAGE_OP || name[0] == VARPACKAGE_OP || name[0] == BUFFER_OP)
 	{
-		acpi_namespace[acpi_namespace_entries].object.type = ACPI_PACKAGE;
-		acpi_namespace[acpi_namespace_entries].object.package = acpi_calloc(sizeof(acpi_object_t), ACPI_MAX_PACKAGE_ENTRIES);
-		acpi_namespace[acpi_namespace_entries].object.package_size = acpins_create_package(acpi_namespace[acpi_namespace_entries].object.package, &name[0]);
+		// packages and buffers are only decoded when they're first used, see acpins_load_object()
+		ACPI_HANDLE(acpi_namespace_entries)->pointer = &name[0];
 
-		//acpi_printf("acpi: package object %s, entry count %d\n", acpi_namespace[acpi_namespace_entries].path, acpi_namespace[acpi_namespace_entries].object.package_size);
+		//acpi_printf("acpi: package object %s, entry count %d\n", ACPI_HANDLE(acpi_namespace_entries)->path, ACPI_HANDLE(acpi_namespace_entries)->object.package_size);
 		acpins_increment_namespace();
 		return return_size;
 	}
 
 	uint64_t integer;
 	size_t integer_size = acpi_eval_integer(name, &integer);
-	size_t pkgsize;
-	acpi_object_t object;
-	size_t object_size;
 
 	if(integer_size != 0)
 	{
-		acpi_namespace[acpi_namespace_entries].object.type = ACPI_INTEGER;
-		acpi_namespace[acpi_namespace_entries].object.integer = integer;
-	} else if(name[0] == BUFFER_OP)
-	{
-		acpi_namespace[acpi_namespace_entries].object.type = ACPI_BUFFER;
-		pkgsize = acpi_parse_pkgsize(&name[1], &acpi_namespace[acpi_namespace_entries].object.buffer_size);
-		acpi_namespace[acpi_namespace_entries].object.buffer = &name[0] + pkgsize + 1;
-
-		object_size = acpi_eval_object(&object, &acpins_state, acpi_namespace[acpi_namespace_entries].object.buffer);
-		acpi_namespace[acpi_namespace_entries].object.buffer += object_size;
-		acpi_namespace[acpi_namespace_entries].object.buffer_size = object.integer;
+		ACPI_HANDLE(acpi_namespace_entries)->object.type = ACPI_INTEGER;
+		ACPI_HANDLE(acpi_namespace_entries)->object.integer = integer;
 	} else if(name[0] == STRINGPREFIX)
 	{
-		acpi_namespace[acpi_namespace_entries].object.type = ACPI_STRING;
-		acpi_namespace[acpi_namespace_entries].object.string = (char*)&name[1];
+		ACPI_HANDLE(acpi_namespace_entries)->object.type = ACPI_STRING;
+		ACPI_HANDLE(acpi_namespace_entries)->object.string = (char*)&name[1];
 	} else
 	{
 		acpi_panic("acpi: undefined opcode in Name(), sequence: %xb %xb %xb %xb\n", name[0], name[1], name[2], name[3]);
 	}
 
-	/*if(acpi_namespace[acpi_namespace_entries].object.type == ACPI_INTEGER)
-		acpi_printf("acpi: integer object %s, value 0x%xq\n", acpi_namespace[acpi_namespace_entries].path, acpi_namespace[acpi_namespace_entries].object.integer);
-	else if(acpi_namespace[acpi_namespace_entries].object.type == ACPI_BUFFER)
-		acpi_printf("acpi: buffer object %s\n", acpi_namespace[acpi_namespace_entries].path);
-	else if(acpi_namespace[acpi_namespace_entries].object.type == ACPI_STRING)
-		acpi_printf("acpi: string object %s: '%s'\n", acpi_namespace[acpi_namespace_entries].path, acpi_namespace[acpi_namespace_entries].object.string);*/
+	/*if(ACPI_HANDLE(acpi_namespace_entries)->object.type == ACPI_INTEGER)
+		acpi_printf("acpi: integer object %s, value 0x%xq\n", ACPI_HANDLE(acpi_namespace_entries)->path, ACPI_HANDLE(acpi_namespace_entries)->object.integer);
+	else if(ACPI_HANDLE(acpi_namespace_entries)->object.type == ACPI_BUFFER)
+		acpi_printf("acpi: buffer object %s\n", ACPI_HANDLE(acpi_namespace_entries)->path);
+	else if(ACPI_HANDLE(acpi_namespace_entries)->object.type == ACPI_STRING)
+		acpi_printf("acpi: string object %s: '%s'\n", ACPI_HANDLE(acpi_namespace_entries)->path, ACPI_HANDLE(acpi_namespace_entries)->object.string);*/
 
 	acpins_increment_namespace();
 	return return_size;
@@ -775,15 +853,15 @@ size_t acpins_create_alias(void *data)
 
 	size_t name_size;
 
-	acpi_namespace[acpi_namespace_entries].type = ACPI_NAMESPACE_ALIAS;
-	name_size = acpins_resolve_path(acpi_namespace[acpi_namespace_entries].alias, alias);
+	ACPI_HANDLE(acpi_namespace_entries)->type = ACPI_NAMESPACE_ALIAS;
+	name_size = acpins_resolve_path(ACPI_HANDLE(acpi_namespace_entries)->alias, alias);
 
 	return_size += name_size;
 	alias += name_size;
 
-	name_size = acpins_resolve_path(acpi_namespace[acpi_namespace_entries].path, alias);
+	name_size = acpins_resolve_path(ACPI_HANDLE(acpi_namespace_entries)->path, alias);
 
-	//acpi_printf("acpi: alias %s for object %s\n", acpi_namespace[acpi_namespace_entries].path, acpi_namespace[acpi_namespace_entries].alias);
+	//acpi_printf("acpi: alias %s for object %s\n", ACPI_HANDLE(acpi_namespace_entries)->path, ACPI_HANDLE(acpi_namespace_entries)->alias);
 
 	acpins_increment_namespace();
 	return_size += name_size;
@@ -800,13 +878,39 @@ size_t acpins_create_mutex(void *data)
 	uint8_t *mutex = (uint8_t*)data;
 	mutex += 2;		// skip MUTEX_OP
 
-	acpi_namespace[acpi_namespace_entries].type = ACPI_NAMESPACE_MUTEX;
-	size_t name_size = acpins_resolve_path(acpi_namespace[acpi_namespace_entries].path, mutex);
+	ACPI_HANDLE(acpi_namespace_entries)->type = ACPI_NAMESPACE_MUTEX;
+	size_t name_size = acpins_resolve_path(ACPI_HANDLE(acpi_namespace_entries)->path, mutex);
+
+	// SyncFlags, the SyncLevel is the low four bits
+	ACPI_HANDLE(acpi_namespace_entries)->mutex = acpi_calloc(sizeof(acpi_mutex_t), 1);
+	ACPI_HANDLE(acpi_namespace_entries)->mutex->sync_level = mutex[name_size] & 0x0F;
 
 	return_size += name_size;
 	return_size++;
 
-	//acpi_printf("acpi: mutex object %s\n", acpi_namespace[acpi_namespace_entries].path);
+	//acpi_printf("acpi: mutex object %s\n", ACPI_HANDLE(acpi_namespace_entries)->path);
+
+	acpins_increment_namespace();
+	return return_size;
+}
+
+// acpins_create_event(): Creates an Event object in the namespace
+// Param:	void *data - pointer to data
+// Return:	size_t - total size in bytes, for skipping
+
+size_t acpins_create_event(void *data)
+{
+	size_t return_size = 2;
+	uint8_t *event = (uint8_t*)data;
+	event += 2;		// skip EVENT_OP
+
+	ACPI_HANDLE(acpi_namespace_entries)->type = ACPI_NAMESPACE_EVENT;
+	size_t name_size = acpins_resolve_path(ACPI_HANDLE(acpi_namespace_entries)->path, event);
+
+	ACPI_HANDLE(acpi_namespace_entries)->event = acpi_calloc(sizeof(acpi_event_t), 1);
+	return_size += name_size;
+
+	//acpi_printf("acpi: event object %s\n", ACPI_HANDLE(acpi_namespace_entries)->path);
 
 	acpins_increment_namespace();
 	return return_size;
@@ -901,16 +1005,16 @@ size_t acpins_create_indexfield(void *data)
 		}
 
 		//acpi_printf("acpi: indexfield %c%c%c%c: size %d bits, at bit offset %d\n", indexfield[0], indexfield[1], indexfield[2], indexfield[3], indexfield[4], current_offset);
-		acpi_namespace[acpi_namespace_entries].type = ACPI_NAMESPACE_INDEXFIELD;
-		acpi_memcpy(acpi_namespace[acpi_namespace_entries].path, acpins_path, acpi_strlen(acpins_path));
-		acpi_namespace[acpi_namespace_entries].path[acpi_strlen(acpins_path)] = '.';
-		acpi_memcpy(acpi_namespace[acpi_namespace_entries].path + acpi_strlen(acpins_path) + 1, indexfield, 4);
+		ACPI_HANDLE(acpi_namespace_entries)->type = ACPI_NAMESPACE_INDEXFIELD;
+		acpi_memcpy(ACPI_HANDLE(acpi_namespace_entries)->path, acpi_context()->path, acpi_strlen(acpi_context()->path));
+		ACPI_HANDLE(acpi_namespace_entries)->path[acpi_strlen(acpi_context()->path)] = '.';
+		acpi_memcpy(ACPI_HANDLE(acpi_namespace_entries)->path + acpi_strlen(acpi_context()->path) + 1, indexfield, 4);
 
-		acpi_strcpy(acpi_namespace[acpi_namespace_entries].indexfield_data, datar);
-		acpi_strcpy(acpi_namespace[acpi_namespace_entries].indexfield_index, indexr);
-		acpi_namespace[acpi_namespace_entries].indexfield_flags = flags;
-		acpi_namespace[acpi_namespace_entries].indexfield_size = indexfield[4];
-		acpi_namespace[acpi_namespace_entries].indexfield_offset = current_offset;
+		acpi_strcpy(ACPI_HANDLE(acpi_namespace_entries)->indexfield_data, datar);
+		acpi_strcpy(ACPI_HANDLE(acpi_namespace_entries)->indexfield_index, indexr);
+		ACPI_HANDLE(acpi_namespace_entries)->indexfield_flags = flags;
+		ACPI_HANDLE(acpi_namespace_entries)->indexfield_size = indexfield[4];
+		ACPI_HANDLE(acpi_namespace_entries)->indexfield_offset = current_offset;
 
 		current_offset += (uint64_t)(indexfield[4]);
 		acpins_increment_namespace();
@@ -922,97 +1026,187 @@ size_t acpins_create_indexfield(void *data)
 	return size + 2;
 }
 
+// acpins_load_object(): Returns the object of a Name(), decoding it if needed
+// Param:	acpi_handle_t *handle - handle of the Name()
+// Return:	acpi_object_t * - the object itself, not a copy
+
+acpi_object_t *acpins_load_object(acpi_handle_t *handle)
+{
+	acpi_context_t *context;
+	acpi_state_t *state;
+	acpi_object_t object;
+	uint8_t *pointer;
+	int depth;
+	char path_save[ACPI_MAX_NAME];
+	size_t scope_save;
+
+	// published last, once the object is there
+#ifdef ACPI_THREADS
+	pointer = __atomic_load_n((uint8_t**)&handle->pointer, __ATOMIC_ACQUIRE);
+#else
+	pointer = handle->pointer;
+#endif
+	if(!pointer)
+		return &handle->object;
+
+	// this belongs to the namespace, so it can't come from a method's arena
+	context = acpi_context();
+	depth = context->arena_depth;
+	context->arena_depth = 0;
+
+	// names and VarPackage() sizes resolve from the scope the Name() is
+	// in, as they would have while loading, not from the running method
+	acpi_strcpy(path_save, context->path);
+	scope_save = context->scope;
+	acpi_strcpy(context->path, handle->path);
+	context->path[acpi_strlen(context->path) - 5] = 0;
+	context->scope = ACPI_NO_SCOPE;
+
+	// decoded without the lock, because VarPackage() sizes may read other
+	// names; buffers are copied out of the AML, so that writes don't end up
+	// in the table
+	state = acpi_push_state(handle->path);
+	if(pointer[0] == BUFFER_OP)
+		acpi_exec_buffer(&object, state, pointer);
+	else
+		acpins_create_package(&object, state, pointer);
+	acpi_pop_state(state);
+
+	acpi_strcpy(context->path, path_save);
+	context->scope = scope_save;
+
+	// another thread may have decoded the same object meanwhile
+	ACPI_LOCK(&acpi_namespace_lock);
+	if(handle->pointer)
+	{
+		handle->object = object;
+#ifdef ACPI_THREADS
+		__atomic_store_n(&handle->pointer, NULL, __ATOMIC_RELEASE);
+#else
+		handle->pointer = NULL;
+#endif
+	} else
+	{
+		acpi_free_object(&object);
+	}
+	ACPI_UNLOCK(&acpi_namespace_lock);
+
+	context->arena_depth = depth;
+	return &handle->object;
+}
+
+// acpins_read_name(): Copies the object of a Name()
+// Param:	acpi_object_t *destination - destination, holds nothing yet
+// Param:	acpi_handle_t *handle - handle of the Name()
+// Return:	Nothing
+
+void acpins_read_name(acpi_object_t *destination, acpi_handle_t *handle)
+{
+	acpi_object_t *object = acpins_load_object(handle);
+
+	// the reference is taken before another thread can drop the data
+	ACPI_LOCK(&acpi_namespace_lock);
+	acpi_copy_object(destination, object);
+	ACPI_UNLOCK(&acpi_namespace_lock);
+}
+
+// acpins_write_name(): Replaces the object of a Name()
+// Param:	acpi_handle_t *handle - handle of the Name()
+// Param:	acpi_object_t *source - object to write
+// Return:	Nothing
+
+void acpins_write_name(acpi_handle_t *handle, acpi_object_t *source)
+{
+	acpi_object_t *object = acpins_load_object(handle);
+
+	ACPI_LOCK(&acpi_namespace_lock);
+	acpi_replace_object(object, source);
+	acpi_persist_object(object);
+	ACPI_UNLOCK(&acpi_namespace_lock);
+}
+
 // acpins_create_package(): Creates a package object
 // Param:	acpi_object_t *destination - where to create package
-// Param:	void *data - package data
-// Return:	size_t - size in entries
+// Param:	acpi_state_t *state - AML VM state, for VarPackage() sizes
+// Param:	void *data - package data, starting at PACKAGE_OP or VARPACKAGE_OP
+// Return:	size_t - total size in bytes, for skipping
 
-size_t acpins_create_package(acpi_object_t *destination, void *data)
+size_t acpins_create_package(acpi_object_t *destination, acpi_state_t *state, void *data)
 {
 	uint8_t *package = (uint8_t*)data;
-	package++;		// skip PACKAGE_OP
-
+	uint8_t *end;
+	acpi_object_t count;
 	size_t pkgsize, size;
-	pkgsize = acpi_parse_pkgsize(package, &size);
-	size_t size_bak = size;
-
-	package += pkgsize;
-	uint8_t count = package[0];		// entry count
-	if(!count)
-		return 0;
-
-	// parse actual package contents
-	package++;
-	uint8_t i = 0;
-	size_t j = 0;
+	size_t i = 0;
 	size_t integer_size;
 	uint64_t integer;
 
+	pkgsize = acpi_parse_pkgsize(&package[1], &size);
+	end = &package[size + 1];
+
+	// NumElements is a byte for Package(), and a TermArg for VarPackage()
+	if(package[0] == PACKAGE_OP)
+	{
+		count.integer = package[pkgsize + 1];
+		package += pkgsize + 2;
+	} else
+	{
+		package += pkgsize + 1;
+		package += acpi_eval_object(&count, state, package);
+	}
+
+	// allocated for the actual number of entries, the ones without
+	// an initializer stay uninitialized
+	destination->type = ACPI_PACKAGE;
+	destination->package_size = count.integer;
+	destination->package = acpi_alloc_counted(sizeof(acpi_object_t) * count.integer);
+
 	//acpi_printf("acpins_create_package: start:\n");
 
-	while(i < count && j + pkgsize + 1 < size_bak)
+	while(i < count.integer && package < end)
 	{
-		integer_size = acpi_eval_integer(&package[j], &integer);
+		integer_size = acpi_eval_integer(package, &integer);
 		if(integer_size != 0)
 		{
-			destination[i].type = ACPI_INTEGER;
-			destination[i].integer = integer;
+			destination->package[i].type = ACPI_INTEGER;
+			destination->package[i].integer = integer;
 
 			//acpi_printf("  index %d: integer %d\n", i, integer);
-			i++;
-			j += integer_size;
-		} else if(package[j] == STRINGPREFIX)
+			package += integer_size;
+		} else if(package[0] == STRINGPREFIX)
 		{
-			destination[i].type = ACPI_STRING;
-			destination[i].string = (char*)&package[j+1];
+			destination->package[i].type = ACPI_STRING;
+			destination->package[i].string = (char*)&package[1];
 
-			//acpi_printf("  index %d: string %s\n", i, destination[i].string);
-			i++;
-
-			j += acpi_strlen((char*)&package[j]) + 1;
-		} else if(acpi_is_name(package[j]) || package[j] == ROOT_CHAR || package[j] == PARENT_CHAR || package[j] == MULTI_PREFIX || package[j] == DUAL_PREFIX)
+			//acpi_printf("  index %d: string %s\n", i, destination->package[i].string);
+			package += acpi_strlen((char*)&package[1]) + 2;
+		} else if(acpi_is_name(package[0]) || package[0] == ROOT_CHAR || package[0] == PARENT_CHAR || package[0] == MULTI_PREFIX || package[0] == DUAL_PREFIX)
 		{
-			destination[i].type = ACPI_NAME;
-			j += acpins_resolve_path(destination[i].name, &package[j]);
+			destination->package[i].type = ACPI_NAME;
+			destination->package[i].name = acpi_alloc_counted(ACPI_MAX_NAME);
+			package += acpins_resolve_path(destination->package[i].name, package);
 
-			//acpi_printf("  index %d: name %s\n", i, destination[i].name);
-			i++;
-		} else if(package[j] == PACKAGE_OP)
+			//acpi_printf("  index %d: name %s\n", i, destination->package[i].name);
+		} else if(package[0] == PACKAGE_OP || package[0] == VARPACKAGE_OP)
 		{
 			// Package within package!
-			destination[i].type = ACPI_PACKAGE;
-			destination[i].package = acpi_calloc(sizeof(acpi_object_t), ACPI_MAX_PACKAGE_ENTRIES);
-
 			//acpi_printf("  index %d: package\n", i);
-
-			destination[i].package_size = acpins_create_package(destination[i].package, &package[j]);
-
-			j++;
-			acpi_parse_pkgsize(&package[j], &size);
-			j += size;
-			i++;
-		} else if(package[j] == BUFFER_OP)
+			package += acpins_create_package(&destination->package[i], state, package);
+		} else if(package[0] == BUFFER_OP)
 		{
 			// Buffer within package
-			destination[i].type = ACPI_BUFFER;
-			j++;
-
-			size_t buffer_size;
-			size_t pkgsize2 = acpi_parse_pkgsize(&package[j], &buffer_size);
-			destination[i].buffer = (void*)&package[j + pkgsize2];
-			destination[i].buffer_size = buffer_size;
-
-			j += buffer_size;
-			i++;
+			package += acpi_exec_buffer(&destination->package[i], state, package);
 		} else
 		{
 			// Undefined here
-			acpi_panic("acpi: undefined opcode in Package(), sequence: %xb %xb %xb %xb\n", package[j], package[j+1], package[j+2], package[j+3]);
+			acpi_panic("acpi: undefined opcode in Package(), sequence: %xb %xb %xb %xb\n", package[0], package[1], package[2], package[3]);
 		}
+
+		i++;
 	}
 
 	//acpi_printf("acpins_create_package: end.\n");
-	return (size_t)count;
+	return size + 1;
 }
 
 // acpins_create_processor(): Creates a Processor object in the namespace
@@ -1028,13 +1222,13 @@ size_t acpins_create_processor(void *data)
 	pkgsize = acpi_parse_pkgsize(processor, &size);
 	processor += pkgsize;
 
-	acpi_namespace[acpi_namespace_entries].type = ACPI_NAMESPACE_PROCESSOR;
-	size_t name_size = acpins_resolve_path(acpi_namespace[acpi_namespace_entries].path, processor);
+	ACPI_HANDLE(acpi_namespace_entries)->type = ACPI_NAMESPACE_PROCESSOR;
+	size_t name_size = acpins_resolve_path(ACPI_HANDLE(acpi_namespace_entries)->path, processor);
 	processor += name_size;
 
-	acpi_namespace[acpi_namespace_entries].cpu_id = processor[0];
+	ACPI_HANDLE(acpi_namespace_entries)->cpu_id = processor[0];
 
-	//acpi_printf("acpi: processor %s ACPI ID %d\n", acpi_namespace[acpi_namespace_entries].path, acpi_namespace[acpi_namespace_entries].cpu_id);
+	//acpi_printf("acpi: processor %s ACPI ID %d\n", ACPI_HANDLE(acpi_namespace_entries)->path, ACPI_HANDLE(acpi_namespace_entries)->cpu_id);
 
 	acpins_increment_namespace();
 
@@ -1051,11 +1245,11 @@ size_t acpins_create_bytefield(void *data)
 	bytefield++;		// skip BYTEFIELD_OP
 	size_t return_size = 1;
 
-	acpi_namespace[acpi_namespace_entries].type = ACPI_NAMESPACE_BUFFER_FIELD;
+	ACPI_HANDLE(acpi_namespace_entries)->type = ACPI_NAMESPACE_BUFFER_FIELD;
 
 	// buffer name
 	size_t name_size;
-	name_size = acpins_resolve_path(acpi_namespace[acpi_namespace_entries].buffer, bytefield);
+	name_size = acpins_resolve_path(ACPI_HANDLE(acpi_namespace_entries)->buffer, bytefield);
 
 	return_size += name_size;
 	bytefield += name_size;
@@ -1064,13 +1258,13 @@ size_t acpins_create_bytefield(void *data)
 	uint64_t integer;
 	integer_size = acpi_eval_integer(bytefield, &integer);
 
-	acpi_namespace[acpi_namespace_entries].buffer_offset = integer * 8;
-	acpi_namespace[acpi_namespace_entries].buffer_size = 8;
+	ACPI_HANDLE(acpi_namespace_entries)->buffer_offset = integer * 8;
+	ACPI_HANDLE(acpi_namespace_entries)->buffer_size = 8;
 
 	return_size += integer_size;
 	bytefield += integer_size;
 
-	name_size = acpins_resolve_path(acpi_namespace[acpi_namespace_entries].path, bytefield);
+	name_size = acpins_resolve_path(ACPI_HANDLE(acpi_namespace_entries)->path, bytefield);
 
 	acpins_increment_namespace();
 	return_size += name_size;
@@ -1087,11 +1281,11 @@ size_t acpins_create_wordfield(void *data)
 	wordfield++;		// skip WORDFIELD_OP
 	size_t return_size = 1;
 
-	acpi_namespace[acpi_namespace_entries].type = ACPI_NAMESPACE_BUFFER_FIELD;
+	ACPI_HANDLE(acpi_namespace_entries)->type = ACPI_NAMESPACE_BUFFER_FIELD;
 
 	// buffer name
 	size_t name_size;
-	name_size = acpins_resolve_path(acpi_namespace[acpi_namespace_entries].buffer, wordfield);
+	name_size = acpins_resolve_path(ACPI_HANDLE(acpi_namespace_entries)->buffer, wordfield);
 
 	return_size += name_size;
 	wordfield += name_size;
@@ -1100,15 +1294,15 @@ size_t acpins_create_wordfield(void *data)
 	uint64_t integer;
 	integer_size = acpi_eval_integer(wordfield, &integer);
 
-	acpi_namespace[acpi_namespace_entries].buffer_offset = integer * 8;
-	acpi_namespace[acpi_namespace_entries].buffer_size = 16;	// bits
+	ACPI_HANDLE(acpi_namespace_entries)->buffer_offset = integer * 8;
+	ACPI_HANDLE(acpi_namespace_entries)->buffer_size = 16;	// bits
 
 	return_size += integer_size;
 	wordfield += integer_size;
 
-	name_size = acpins_resolve_path(acpi_namespace[acpi_namespace_entries].path, wordfield);
+	name_size = acpins_resolve_path(ACPI_HANDLE(acpi_namespace_entries)->path, wordfield);
 
-	//acpi_printf("acpi: field %s for buffer %s, offset %d size %d bits\n", acpi_namespace[acpi_namespace_entries].path, acpi_namespace[acpi_namespace_entries].buffer, acpi_namespace[acpi_namespace_entries].buffer_offset, acpi_namespace[acpi_namespace_entries].buffer_size);
+	//acpi_printf("acpi: field %s for buffer %s, offset %d size %d bits\n", ACPI_HANDLE(acpi_namespace_entries)->path, ACPI_HANDLE(acpi_namespace_entries)->buffer, ACPI_HANDLE(acpi_namespace_entries)->buffer_offset, ACPI_HANDLE(acpi_namespace_entries)->buffer_size);
 
 	acpins_increment_namespace();
 	return_size += name_size;
@@ -1125,11 +1319,11 @@ size_t acpins_create_dwordfield(void *data)
 	dwordfield++;		// skip DWORDFIELD_OP
 	size_t return_size = 1;
 
-	acpi_namespace[acpi_namespace_entries].type = ACPI_NAMESPACE_BUFFER_FIELD;
+	ACPI_HANDLE(acpi_namespace_entries)->type = ACPI_NAMESPACE_BUFFER_FIELD;
 
 	// buffer name
 	size_t name_size;
-	name_size = acpins_resolve_path(acpi_namespace[acpi_namespace_entries].buffer, dwordfield);
+	name_size = acpins_resolve_path(ACPI_HANDLE(acpi_namespace_entries)->buffer, dwordfield);
 
 	return_size += name_size;
 	dwordfield += name_size;
@@ -1138,13 +1332,13 @@ size_t acpins_create_dwordfield(void *data)
 	uint64_t integer;
 	integer_size = acpi_eval_integer(dwordfield, &integer);
 
-	acpi_namespace[acpi_namespace_entries].buffer_offset = integer * 8;
-	acpi_namespace[acpi_namespace_entries].buffer_size = 32;
+	ACPI_HANDLE(acpi_namespace_entries)->buffer_offset = integer * 8;
+	ACPI_HANDLE(acpi_namespace_entries)->buffer_size = 32;
 
 	return_size += integer_size;
 	dwordfield += integer_size;
 
-	name_size = acpins_resolve_path(acpi_namespace[acpi_namespace_entries].path, dwordfield);
+	name_size = acpins_resolve_path(ACPI_HANDLE(acpi_namespace_entries)->path, dwordfield);
 
 	acpins_increment_namespace();
 	return_size += name_size;
@@ -1161,11 +1355,11 @@ size_t acpins_create_qwordfield(void *data)
 	qwordfield++;		// skip QWORDFIELD_OP
 	size_t return_size = 1;
 
-	acpi_namespace[acpi_namespace_entries].type = ACPI_NAMESPACE_BUFFER_FIELD;
+	ACPI_HANDLE(acpi_namespace_entries)->type = ACPI_NAMESPACE_BUFFER_FIELD;
 
 	// buffer name
 	size_t name_size;
-	name_size = acpins_resolve_path(acpi_namespace[acpi_namespace_entries].buffer, qwordfield);
+	name_size = acpins_resolve_path(ACPI_HANDLE(acpi_namespace_entries)->buffer, qwordfield);
 
 	return_size += name_size;
 	qwordfield += name_size;
@@ -1174,13 +1368,13 @@ size_t acpins_create_qwordfield(void *data)
 	uint64_t integer;
 	integer_size = acpi_eval_integer(qwordfield, &integer);
 
-	acpi_namespace[acpi_namespace_entries].buffer_offset = integer * 8;
-	acpi_namespace[acpi_namespace_entries].buffer_size = 64;
+	ACPI_HANDLE(acpi_namespace_entries)->buffer_offset = integer * 8;
+	ACPI_HANDLE(acpi_namespace_entries)->buffer_size = 64;
 
 	return_size += integer_size;
 	qwordfield += integer_size;
 
-	name_size = acpins_resolve_path(acpi_namespace[acpi_namespace_entries].path, qwordfield);
+	name_size = acpins_resolve_path(ACPI_HANDLE(acpi_namespace_entries)->path, qwordfield);
 
 	acpins_increment_namespace();
 	return_size += name_size;
@@ -1200,8 +1394,8 @@ acpi_handle_t *acpins_resolve(char *path)
 		// yep, search for the absolute path
 		while(i < acpi_namespace_entries)
 		{
-			if(acpi_strcmp(acpi_namespace[i].path, path) == 0)
-				return &acpi_namespace[i];
+			if(acpi_strcmp(ACPI_HANDLE(i)->path, path) == 0)
+				return ACPI_HANDLE(i);
 
 			else
 				i++;
@@ -1212,8 +1406,8 @@ acpi_handle_t *acpins_resolve(char *path)
 	{
 		while(i < acpi_namespace_entries)
 		{
-			if(acpi_memcmp(acpi_namespace[i].path + acpi_strlen(acpi_namespace[i].path) - 4, path, 4) == 0)
-				return &acpi_namespace[i];
+			if(acpi_memcmp(ACPI_HANDLE(i)->path + acpi_strlen(ACPI_HANDLE(i)->path) - 4, path, 4) == 0)
+				return ACPI_HANDLE(i);
 
 			else
 				i++;
@@ -1232,11 +1426,15 @@ acpi_handle_t *acpins_get_device(size_t index)
 	size_t i = 0, j = 0;
 	while(j < acpi_namespace_entries)
 	{
-		if(acpi_namespace[j].type == ACPI_NAMESPACE_DEVICE)
-			i++;
+		// devices that acpi_init_devices() found absent are not exposed
+		if(ACPI_HANDLE(j)->type == ACPI_NAMESPACE_DEVICE)
+		{
+			if(!ACPI_HANDLE(j)->device_status_valid || (ACPI_HANDLE(j)->device_status & ACPI_STA_PRESENT) != 0)
+				i++;
+		}
 
 		if(i > index)
-			return &acpi_namespace[j];
+			return ACPI_HANDLE(j);
 
 		j++;
 	}
@@ -1291,6 +1489,117 @@ acpi_handle_t *acpins_get_deviceid(size_t index, acpi_object_t *id)
 	return NULL;
 }
 
+// acpins_get_parent_device(): Returns the closest parent device of an object
+// Param:	acpi_handle_t *handle - namespace object
+// Return:	acpi_handle_t * - parent device, NULL if the object is not within a device
+
+acpi_handle_t *acpins_get_parent_device(acpi_handle_t *handle)
+{
+	char path[ACPI_MAX_NAME];
+	acpi_handle_t *parent;
+
+	acpi_strcpy(path, handle->path);
+
+	// strip one name segment at a time, "\\.XXXX" is the shortest path below the root
+	while(acpi_strlen(path) > 6)
+	{
+		path[acpi_strlen(path) - 5] = 0;
+
+		parent = acpins_resolve(path);
+		if(parent && parent->type == ACPI_NAMESPACE_DEVICE)
+			return parent;
+	}
+
+	return NULL;
+}
+
+// acpins_get_status(): Returns the status of a device, evaluating _STA only once
+// Param:	acpi_handle_t *device - device handle
+// Return:	uint64_t - _STA value
+
+uint64_t acpins_get_status(acpi_handle_t *device)
+{
+	if(device->device_status_valid)
+		return device->device_status;
+
+	// evaluating AML may grow the namespace, so don't hold on to the pointer
+	size_t index = device->index;
+	uint64_t status;
+
+	char path[ACPI_MAX_NAME];
+	acpi_object_t sta;
+	acpi_handle_t *parent = acpins_get_parent_device(device);
+
+	if(parent && (acpins_get_status(parent) & (ACPI_STA_PRESENT | ACPI_STA_FUNCTION)) == 0)
+	{
+		// when a device is neither present nor functioning, the ACPI spec says
+		// its children must be treated the same way, without evaluating them
+		status = 0;
+	} else
+	{
+		acpi_strcpy(path, ACPI_HANDLE(index)->path);
+		acpi_strcpy(path + acpi_strlen(path), "._STA");
+
+		// when _STA is not present, the device is present and functioning
+		status = ACPI_STA_DEFAULT;
+		if(acpins_resolve(path))
+		{
+			acpi_memset(&sta, 0, sizeof(acpi_object_t));
+			if(acpi_eval(&sta, path) == 0 && sta.type == ACPI_INTEGER)
+				status = sta.integer;
+		}
+	}
+
+	ACPI_HANDLE(index)->device_status = status;
+	ACPI_HANDLE(index)->device_status_valid = 1;
+	return status;
+}
+
+// acpi_init_devices(): Runs _INI on all present devices and caches their _STA
+// Param:	Nothing
+// Return:	Nothing
+
+void acpi_init_devices()
+{
+	char path[ACPI_MAX_NAME];
+	acpi_object_t object;
+	acpi_handle_t *handle;
+	size_t i = 0, count = 0;
+
+	// the ACPI spec says \_SB_._INI runs before any device is initialized
+	handle = acpins_resolve("\\._SB_._INI");
+	if(handle && handle->type == ACPI_NAMESPACE_METHOD)
+	{
+		acpi_strcpy(path, handle->path);
+		acpi_eval(&object, path);
+	}
 
+	// the namespace is in the order the AML declares it, so parents come
+	// before their children and _INI runs top-down as the spec requires
+	while(i < acpi_namespace_entries)
+	{
+		if(ACPI_HANDLE(i)->type != ACPI_NAMESPACE_DEVICE)
+		{
+			i++;
+			continue;
+		}
+
+		// present devices get initialized, functioning-only devices don't,
+		// but their children are still evaluated by acpins_get_status()
+		if(acpins_get_status(ACPI_HANDLE(i)) & ACPI_STA_PRESENT)
+		{
+			acpi_strcpy(path, ACPI_HANDLE(i)->path);
+			acpi_strcpy(path + acpi_strlen(path), "._INI");
 
+			handle = acpins_resolve(path);
+			if(handle && handle->type == ACPI_NAMESPACE_METHOD)
+				acpi_eval(&object, path);
 
+			count++;
+		}
+
+		i++;
+	}
+
+	acpi_printf("acpi: initialized devices, total of %d devices present.\n", (int)count);
+}
@@ -95,18 +95,18 @@ int acpi_pci_route(acpi_resource_t *dest, uint8_t bus, uint8_t slot, uint8_t fun
 		// read the _PRT package
 		status = acpi_eval_package(&prt, i, &prt_package);
 		if(status != 0)
-			return 1;
+			goto fail;
 
 		if(prt_package.type != ACPI_PACKAGE)
-			return 1;
+			goto fail;
 
 		// read the device address
 		status = acpi_eval_package(&prt_package, 0, &prt_entry);
 		if(status != 0)
-			return 1;
+			goto fail;
 
 		if(prt_entry.type != ACPI_INTEGER)
-			return 1;
+			goto fail;
 
 		// is this the device we want?
 		if((prt_entry.integer >> 16) == slot)
@@ -116,10 +116,10 @@ int acpi_pci_route(acpi_resource_t *dest, uint8_t bus, uint8_t slot, uint8_t fun
 				// is this the interrupt pin we want?
 				status = acpi_eval_package(&prt_package, 1, &prt_entry);
 				if(status != 0)
-					return 1;
+					goto fail;
 
 				if(prt_entry.type != ACPI_INTEGER)
-					return 1;
+					goto fail;
 
 				if(prt_entry.integer == pin)
 					goto resolve_pin;
@@ -135,7 +135,7 @@ resolve_pin:
 	// is it a link device or a GSI?
 	status = acpi_eval_package(&prt_package, 2, &prt_entry);
 	if(status != 0)
-		return 1;
+		goto fail;
 
 	acpi_handle_t *link;		// PCI link device
 	acpi_resource_t *res;
@@ -146,20 +146,22 @@ resolve_pin:
 		// GSI
 		status = acpi_eval_package(&prt_package, 3, &prt_entry);
 		if(status != 0)
-			return 1;
+			goto fail;
 
 		dest->type = ACPI_RESOURCE_IRQ;
 		dest->base = prt_entry.integer;
 		dest->irq_flags = ACPI_IRQ_LEVEL | ACPI_IRQ_ACTIVE_HIGH | ACPI_IRQ_SHARED;
 
 		acpi_printf("acpi: PCI device %xb:%xb:%xb is using IRQ %d\n", bus, slot, function, (int)dest->base);
-		return 0;
+		goto done;
 	} else if(prt_entry.type == ACPI_NAME)
 	{
 		// PCI Interrupt Link Device
-		link = acpi_exec_resolve(prt_entry.name);
+		// acpi_exec_resolve() modifies the path, and this one belongs to _PRT
+		acpi_strcpy(path, prt_entry.name);
+		link = acpi_exec_resolve(path);
 		if(!link)
-			return 1;
+			goto fail;
 
 		acpi_printf("acpi: PCI interrupt link is %s\n", link->path);
 
@@ -168,7 +170,7 @@ resolve_pin:
 		res_count = acpi_read_resource(link, res);
 
 		if(!res_count)
-			return 1;
+			goto fail;
 
 		i = 0;
 		while(i < res_count)
@@ -182,15 +184,23 @@ resolve_pin:
 				acpi_free(res);
 
 				acpi_printf("acpi: PCI device %xb:%xb:%xb is using IRQ %d\n", bus, slot, function, (int)dest->base);
-				return 0;
+				goto done;
 			}
 
 			i++;
 		}
 
-		return 0;
-	} else
-		return 1;
+		goto done;
+	}
+
+fail:
+	acpi_free_object(&prt);
+	return 1;
+
+done:
+	// prt_package and prt_entry only borrow from _PRT, so they go with it
+	acpi_free_object(&prt);
+	return 0;
 }
 
 
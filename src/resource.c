@@ -62,7 +62,7 @@ size_t acpi_read_resource(acpi_handle_t *device, acpi_resource_t *dest)
 			switch(data[0] >> 3)
 			{
 			case ACPI_SMALL_END:
-				return count;
+				goto done;
 
 			case ACPI_SMALL_IRQ:
 				small_irq = (acpi_small_irq_t*)&data[0];
@@ -96,7 +96,8 @@ size_t acpi_read_resource(acpi_handle_t *device, acpi_resource_t *dest)
 
 			default:
 				acpi_printf("acpi warning: undefined small resource, byte 0 is %xb, ignoring...\n", data[0]);
-				return 0;
+				count = 0;
+				goto done;
 			}
 		} else
 		{
@@ -119,11 +120,14 @@ size_t acpi_read_resource(acpi_handle_t *device, acpi_resource_t *dest)
 
 			default:
 				acpi_printf("acpi warning: undefined large resource, byte 0 is %xb, ignoring...\n", data[0]);
-				return 0;
+				count = 0;
+				goto done;
 			}
 		}
 	}
 
+done:
+	acpi_free_object(&buffer);
 	return count;
 }
 
@@ -46,41 +46,45 @@ int acpi_enter_sleep(uint8_t state)
 
 	// ACPI spec says we should call _PTS() and _GTS() before actually sleeping
 	// Who knows, it might do some required firmware-specific stuff
-	acpi_state_t acpi_state;
-	acpi_memset(&acpi_state, 0, sizeof(acpi_state_t));
+	// the states come from the pool, which releases whatever the methods leave in them
+	acpi_state_t *acpi_state;
 	handle = acpins_resolve("_PTS");
 
 	acpi_object_t object;
 
 	if(handle)
 	{
-		acpi_strcpy(acpi_state.name, handle->path);
+		acpi_state = acpi_push_state(handle->path);
 
 		// pass the sleeping type as an argument
-		acpi_state.arg[0].type = ACPI_INTEGER;
-		acpi_state.arg[0].integer = (uint64_t)state & 0xFF;
+		acpi_state->arg[0].type = ACPI_INTEGER;
+		acpi_state->arg[0].integer = (uint64_t)state & 0xFF;
 
 		acpi_printf("acpi: execute _PTS(%d)\n", state);
-		acpi_exec_method(&acpi_state, &object);
+		acpi_exec_method(acpi_state, &object);
+		acpi_free_object(&object);
+		acpi_pop_state(acpi_state);
 	}
 
-	acpi_memset(&acpi_state, 0, sizeof(acpi_state_t));
 	handle = acpins_resolve("_GTS");
 
 	if(handle)
 	{
-		acpi_strcpy(acpi_state.name, handle->path);
+		acpi_state = acpi_push_state(handle->path);
 
 		// pass the sleeping type as an argument
-		acpi_state.arg[0].type = ACPI_INTEGER;
-		acpi_state.arg[0].integer = (uint64_t)state & 0xFF;
+		acpi_state->arg[0].type = ACPI_INTEGER;
+		acpi_state->arg[0].integer = (uint64_t)state & 0xFF;
 
 		acpi_printf("acpi: execute _GTS(%d)\n", state);
-		acpi_exec_method(&acpi_state, &object);
+		acpi_exec_method(acpi_state, &object);
+		acpi_free_object(&object);
+		acpi_pop_state(acpi_state);
 	}
 
 	acpi_eval_package(&package, 0, &slp_typa);
 	acpi_eval_package(&package, 1, &slp_typb);
+	acpi_free_object(&package);
 
 	// and go to sleep
 	uint16_t data;
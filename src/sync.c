@@ -0,0 +1,484 @@
+
+/*
+ * Lux ACPI Implementation
+ * Copyright (C) 2018 by Omar Mohammad
+ */
+
+/* AML Synchronization */
+/* Mutexes belong to the context that acquired them, which may acquire them
+ * again. Each has a SyncLevel, and a context may only acquire mutexes at or
+ * above the level of those it holds, and release them in the opposite order,
+ * so that AML can't deadlock on itself. An uncontended Acquire() is a single
+ * compare-and-swap; with ACPI_THREADS, a contended one sleeps in acpi_wait()
+ * until the owner releases the mutex or the timeout runs out, unless the
+ * method was started with acpi_start_method() and can stop. Firmware that
+ * breaks the ordering gets a warning, not a panic: the Acquire() fails and
+ * the Release() does nothing.
+ * Events count the Signal()s no Wait() consumed yet. The OS signals them
+ * too, from GPE handlers or Notify(), and waiters sleep in acpi_wait()
+ * rather than poll. Without ACPI_THREADS, nothing can signal an event while
+ * a Wait() holds the CPU, so only methods that can stop wait for the OS. */
+
+#include "lai.h"
+
+// owners change under other threads, which wait on the sequence number
+#ifdef ACPI_THREADS
+#define ACPI_MUTEX_OWNER(mutex)		__atomic_load_n(&(mutex)->owner, __ATOMIC_ACQUIRE)
+#define ACPI_MUTEX_CLAIM(mutex, context)	__atomic_compare_exchange_n(&(mutex)->owner, &(acpi_context_t *){NULL}, context, 0, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED)
+#define ACPI_MUTEX_FREE(mutex)		__atomic_store_n(&(mutex)->owner, NULL, __ATOMIC_RELEASE)
+#else
+#define ACPI_MUTEX_OWNER(mutex)		((mutex)->owner)
+#define ACPI_MUTEX_CLAIM(mutex, context)	(!(mutex)->owner && ((mutex)->owner = (context)))
+#define ACPI_MUTEX_FREE(mutex)		((mutex)->owner = NULL)
+#endif
+
+void acpi_own_mutex(acpi_mutex_t *);
+int acpi_stopped_mutex(acpi_mutex_t *);
+void acpi_unlink_mutex(acpi_mutex_t *);
+void acpi_free_mutex(acpi_mutex_t *);
+acpi_mutex_t *acpi_exec_mutex(uint8_t *, size_t *);
+acpi_event_t *acpi_exec_event(uint8_t *, size_t *);
+
+// acpi_acquire_mutex(): Acquires a mutex for the running context
+// Param:	acpi_mutex_t *mutex - mutex
+// Param:	uint16_t timeout - in milliseconds, ACPI_FOREVER to wait as long as it takes
+// Return:	int - 0 when acquired, 1 when the timeout ran out or the SyncLevel is too low
+
+int acpi_acquire_mutex(acpi_mutex_t *mutex, uint16_t timeout)
+{
+	int status = acpi_try_mutex(mutex);
+	if(status != ACPI_WOULD_BLOCK)
+		return status ? 1 : 0;
+
+#ifdef ACPI_THREADS
+	acpi_context_t *context = acpi_context();
+	uint64_t deadline = 0, now;
+	uint32_t sequence;
+
+	while(1)
+	{
+		// read before trying, so that a release in between wakes us
+		sequence = __atomic_load_n(&mutex->sequence, __ATOMIC_SEQ_CST);
+		if(ACPI_MUTEX_CLAIM(mutex, context))
+			break;
+
+		if(timeout != ACPI_FOREVER)
+		{
+			now = acpi_timer();
+			if(!deadline)
+				deadline = now + (uint64_t)timeout * 10000;
+			if(now >= deadline)
+				return 1;
+		}
+
+		__atomic_add_fetch(&mutex->waiters, 1, __ATOMIC_SEQ_CST);
+		acpi_wait(&mutex->sequence, sequence, (timeout == ACPI_FOREVER) ? (uint64_t)-1 : deadline - now);
+		__atomic_sub_fetch(&mutex->waiters, 1, __ATOMIC_SEQ_CST);
+	}
+
+	acpi_own_mutex(mutex);
+	return 0;
+#else
+	// there's only one context, so no one else can release it
+	return 1;
+#endif
+}
+
+// acpi_try_mutex(): Acquires a mutex for the running context, unless another context holds it
+// Param:	acpi_mutex_t *mutex - mutex
+// Return:	int - 0 when acquired, -1 when the SyncLevel is too low, ACPI_WOULD_BLOCK when it's held
+
+int acpi_try_mutex(acpi_mutex_t *mutex)
+{
+	acpi_context_t *context = acpi_context();
+
+	if(ACPI_MUTEX_OWNER(mutex) == context)
+	{
+		// the stopped method can't release it before the OS resumes it
+		if(acpi_stopped_mutex(mutex))
+		{
+			acpi_printf("acpi: %s acquires a mutex its stopped method holds, failing...\n", context->path);
+			return -1;
+		}
+
+		mutex->depth++;
+		return 0;
+	}
+
+	if(mutex->sync_level < context->sync_level)
+	{
+		acpi_printf("acpi: %s acquires a mutex at SyncLevel %d while holding SyncLevel %d, failing...\n", context->path, mutex->sync_level, context->sync_level);
+		return -1;
+	}
+
+	if(!ACPI_MUTEX_CLAIM(mutex, context))
+		return ACPI_WOULD_BLOCK;
+
+	acpi_own_mutex(mutex);
+	return 0;
+}
+
+// acpi_own_mutex(): Records a mutex the running context just claimed
+// Param:	acpi_mutex_t *mutex - mutex
+// Return:	Nothing
+
+void acpi_own_mutex(acpi_mutex_t *mutex)
+{
+	acpi_context_t *context = acpi_context();
+
+	mutex->depth = 1;
+	context->sync_level = mutex->sync_level;
+
+	mutex->next = context->mutexes;
+	context->mutexes = mutex;
+}
+
+// acpi_stopped_mutex(): Tells whether the stopped method of the running context holds a mutex
+// Param:	acpi_mutex_t *mutex - mutex the context owns
+// Return:	int - 1 when the stopped method holds it, 0 when the running call does
+
+int acpi_stopped_mutex(acpi_mutex_t *mutex)
+{
+	acpi_mutex_t *held;
+
+	// empty unless a method is stopped, see acpi_swap_call()
+	for(held = acpi_context()->stopped.mutexes; held; held = held->next)
+	{
+		if(held == mutex)
+			return 1;
+	}
+
+	return 0;
+}
+
+// acpi_release_mutex(): Releases a mutex the running context acquired
+// Param:	acpi_mutex_t *mutex - mutex
+// Return:	Nothing
+
+void acpi_release_mutex(acpi_mutex_t *mutex)
+{
+	acpi_context_t *context = acpi_context();
+
+	if(ACPI_MUTEX_OWNER(mutex) != context || acpi_stopped_mutex(mutex))
+	{
+		acpi_printf("acpi: %s releases a mutex it doesn't hold, ignoring...\n", context->path);
+		return;
+	}
+
+	// anything acquired after this one goes first, even at the same level
+	if(mutex->depth == 1 && context->mutexes != mutex)
+	{
+		acpi_printf("acpi: %s releases a mutex before one it acquired later, ignoring...\n", context->path);
+		return;
+	}
+
+	mutex->depth--;
+	if(mutex->depth)
+		return;
+
+	// what's left is ordered the same way, so the first one has the level
+	acpi_unlink_mutex(mutex);
+	context->sync_level = context->mutexes ? context->mutexes->sync_level : 0;
+	acpi_free_mutex(mutex);
+}
+
+// acpi_release_method_mutex(): Releases the mutex of a Serialized method as it returns
+// Param:	acpi_mutex_t *mutex - mutex of the method
+// Return:	Nothing
+
+void acpi_release_method_mutex(acpi_mutex_t *mutex)
+{
+	acpi_context_t *context = acpi_context();
+
+	mutex->depth--;
+	if(mutex->depth)
+		return;
+
+	// the method may return holding mutexes it acquired, which is no reason
+	// to panic, and the SyncLevel is that of the last one still held
+	acpi_unlink_mutex(mutex);
+	context->sync_level = context->mutexes ? context->mutexes->sync_level : 0;
+	acpi_free_mutex(mutex);
+}
+
+// acpi_release_mutexes(): Releases what the running context still holds, once its method returns
+// Param:	Nothing
+// Return:	Nothing
+
+void acpi_release_mutexes()
+{
+	acpi_context_t *context = acpi_context();
+	acpi_mutex_t *mutex;
+
+	while(context->mutexes)
+	{
+		mutex = context->mutexes;
+		context->mutexes = mutex->next;
+		mutex->depth = 0;
+		acpi_free_mutex(mutex);
+	}
+
+	context->sync_level = 0;
+}
+
+// acpi_unlink_mutex(): Removes a mutex from the ones the running context holds
+// Param:	acpi_mutex_t *mutex - mutex
+// Return:	Nothing
+
+void acpi_unlink_mutex(acpi_mutex_t *mutex)
+{
+	acpi_mutex_t **link = &acpi_context()->mutexes;
+
+	// usually the first, because mutexes are released in reverse order
+	while(*link != mutex)
+		link = &(*link)->next;
+
+	*link = mutex->next;
+}
+
+// acpi_free_mutex(): Gives up ownership of a mutex, and wakes anything waiting for it
+// Param:	acpi_mutex_t *mutex - mutex
+// Return:	Nothing
+
+void acpi_free_mutex(acpi_mutex_t *mutex)
+{
+	ACPI_MUTEX_FREE(mutex);
+
+#ifdef ACPI_THREADS
+	__atomic_add_fetch(&mutex->sequence, 1, __ATOMIC_SEQ_CST);
+	if(__atomic_load_n(&mutex->waiters, __ATOMIC_SEQ_CST))
+		acpi_wake(&mutex->sequence);
+#endif
+}
+
+// acpi_exec_mutex(): Resolves the operand of Acquire() or Release()
+// Param:	uint8_t *aml - NameString of the mutex
+// Param:	size_t *size - size of the NameString in bytes
+// Return:	acpi_mutex_t * - mutex
+
+acpi_mutex_t *acpi_exec_mutex(uint8_t *aml, size_t *size)
+{
+	char name[ACPI_MAX_NAME];
+	acpi_handle_t *handle = acpi_exec_resolve_name(aml, size);
+
+	if(!handle || handle->type != ACPI_NAMESPACE_MUTEX)
+	{
+		acpins_resolve_path(name, aml);
+		acpi_panic("acpi: %s is not a mutex\n", name);
+	}
+
+	return handle->mutex;
+}
+
+// acpi_eval_acquire(): Evaluates an Acquire() opcode
+// Param:	acpi_object_t *destination - 1 when it timed out, 0 otherwise
+// Param:	acpi_state_t *state - AML VM state
+// Param:	void *data - opcode data
+// Return:	size_t - size in bytes for skipping
+
+size_t acpi_eval_acquire(acpi_object_t *destination, acpi_state_t *state, void *data)
+{
+	uint8_t *opcode = (uint8_t*)data;
+	size_t name_size;
+	acpi_mutex_t *mutex = acpi_exec_mutex(&opcode[2], &name_size);	// skip EXTOP_PREFIX and ACQUIRE_OP
+	uint16_t timeout = opcode[2 + name_size] | (opcode[3 + name_size] << 8);
+
+	destination->type = ACPI_INTEGER;
+	destination->integer = acpi_acquire_mutex(mutex, timeout);
+	return name_size + 4;
+}
+
+// acpi_exec_acquire(): Executes an Acquire() opcode, whose result is discarded
+// Param:	void *data - opcode data
+// Param:	acpi_state_t *state - AML VM state
+// Return:	size_t - size in bytes for skipping
+
+size_t acpi_exec_acquire(void *data, acpi_state_t *state)
+{
+	acpi_object_t timed_out;
+	return acpi_eval_acquire(&timed_out, state, data);
+}
+
+// acpi_exec_release(): Executes a Release() opcode
+// Param:	void *data - opcode data
+// Param:	acpi_state_t *state - AML VM state
+// Return:	size_t - size in bytes for skipping
+
+size_t acpi_exec_release(void *data, acpi_state_t *state)
+{
+	uint8_t *opcode = (uint8_t*)data;
+	size_t name_size;
+	acpi_mutex_t *mutex = acpi_exec_mutex(&opcode[2], &name_size);	// skip EXTOP_PREFIX and RELEASE_OP
+
+	acpi_release_mutex(mutex);
+	return name_size + 2;
+}
+
+// acpi_get_event(): Looks up an Event() object, for the OS to signal
+// Param:	char *path - path of the event
+// Return:	acpi_event_t * - event, NULL if there is no event there
+
+acpi_event_t *acpi_get_event(char *path)
+{
+	acpi_handle_t *handle = acpins_resolve(path);
+	if(!handle || handle->type != ACPI_NAMESPACE_EVENT)
+		return NULL;
+
+	return handle->event;
+}
+
+// acpi_signal_event(): Signals an event, for Signal() and for the OS
+// Param:	acpi_event_t *event - event
+// Return:	Nothing
+
+void acpi_signal_event(acpi_event_t *event)
+{
+	// atomic even without ACPI_THREADS, as interrupt handlers may signal;
+	// they may only do so when acpi_wake() is safe there as well
+	__atomic_add_fetch(&event->count, 1, __ATOMIC_SEQ_CST);
+
+#ifdef ACPI_THREADS
+	__atomic_add_fetch(&event->sequence, 1, __ATOMIC_SEQ_CST);
+	if(__atomic_load_n(&event->waiters, __ATOMIC_SEQ_CST))
+		acpi_wake(&event->sequence);
+#endif
+}
+
+// acpi_wait_event(): Waits for an event to be signaled, and consumes the signal
+// Param:	acpi_event_t *event - event
+// Param:	uint64_t timeout - in milliseconds, ACPI_FOREVER or more to wait as long as it takes
+// Return:	int - 0 when signaled, 1 when the timeout ran out, at once without ACPI_THREADS
+
+int acpi_wait_event(acpi_event_t *event, uint64_t timeout)
+{
+	uint32_t count;
+#ifdef ACPI_THREADS
+	uint64_t deadline = 0, now;
+	uint32_t sequence;
+#endif
+
+	while(1)
+	{
+#ifdef ACPI_THREADS
+		// read before looking, so that a Signal() in between wakes us
+		sequence = __atomic_load_n(&event->sequence, __ATOMIC_SEQ_CST);
+#endif
+		count = __atomic_load_n(&event->count, __ATOMIC_SEQ_CST);
+		if(count)
+		{
+			// another waiter may take it first
+			if(__atomic_compare_exchange_n(&event->count, &count, count - 1, 0, __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST))
+				return 0;
+			continue;
+		}
+
+#ifdef ACPI_THREADS
+		now = acpi_timer();
+		if(timeout < ACPI_FOREVER)
+		{
+			if(!deadline)
+				deadline = now + timeout * 10000;
+			if(now >= deadline)
+				return 1;
+		}
+
+		__atomic_add_fetch(&event->waiters, 1, __ATOMIC_SEQ_CST);
+		acpi_wait(&event->sequence, sequence, (timeout < ACPI_FOREVER) ? deadline - now : (uint64_t)-1);
+		__atomic_sub_fetch(&event->waiters, 1, __ATOMIC_SEQ_CST);
+#else
+		// there's only one context, like for a mutex held by someone else
+		return 1;
+#endif
+	}
+}
+
+// acpi_reset_event(): Drops the signals no one waited for yet, for Reset()
+// Param:	acpi_event_t *event - event
+// Return:	Nothing
+
+void acpi_reset_event(acpi_event_t *event)
+{
+	__atomic_store_n(&event->count, 0, __ATOMIC_SEQ_CST);
+}
+
+// acpi_exec_event(): Resolves the operand of Wait(), Signal() or Reset()
+// Param:	uint8_t *aml - NameString of the event
+// Param:	size_t *size - size of the NameString in bytes
+// Return:	acpi_event_t * - event
+
+acpi_event_t *acpi_exec_event(uint8_t *aml, size_t *size)
+{
+	char name[ACPI_MAX_NAME];
+	acpi_handle_t *handle = acpi_exec_resolve_name(aml, size);
+
+	if(!handle || handle->type != ACPI_NAMESPACE_EVENT)
+	{
+		acpins_resolve_path(name, aml);
+		acpi_panic("acpi: %s is not an event\n", name);
+	}
+
+	return handle->event;
+}
+
+// acpi_eval_wait(): Evaluates a Wait() opcode
+// Param:	acpi_object_t *destination - 1 when it timed out, 0 otherwise
+// Param:	acpi_state_t *state - AML VM state
+// Param:	void *data - opcode data
+// Return:	size_t - size in bytes for skipping
+
+size_t acpi_eval_wait(acpi_object_t *destination, acpi_state_t *state, void *data)
+{
+	uint8_t *opcode = (uint8_t*)data;
+	size_t return_size = 2;		// EXTOP_PREFIX and WAIT_OP
+	size_t name_size;
+	acpi_event_t *event = acpi_exec_event(&opcode[2], &name_size);
+	return_size += name_size;
+
+	acpi_object_t timeout;
+	return_size += acpi_eval_object(&timeout, state, &opcode[return_size]);
+
+	destination->type = ACPI_INTEGER;
+	destination->integer = acpi_wait_event(event, timeout.integer);
+	return return_size;
+}
+
+// acpi_exec_wait(): Executes a Wait() opcode, whose result is discarded
+// Param:	void *data - opcode data
+// Param:	acpi_state_t *state - AML VM state
+// Return:	size_t - size in bytes for skipping
+
+size_t acpi_exec_wait(void *data, acpi_state_t *state)
+{
+	acpi_object_t timed_out;
+	return acpi_eval_wait(&timed_out, state, data);
+}
+
+// acpi_exec_signal(): Executes a Signal() opcode
+// Param:	void *data - opcode data
+// Param:	acpi_state_t *state - AML VM state
+// Return:	size_t - size in bytes for skipping
+
+size_t acpi_exec_signal(void *data, acpi_state_t *state)
+{
+	uint8_t *opcode = (uint8_t*)data;
+	size_t name_size;
+	acpi_event_t *event = acpi_exec_event(&opcode[2], &name_size);	// skip EXTOP_PREFIX and SIGNAL_OP
+
+	acpi_signal_event(event);
+	return name_size + 2;
+}
+
+// acpi_exec_reset(): Executes a Reset() opcode
+// Param:	void *data - opcode data
+// Param:	acpi_state_t *state - AML VM state
+// Return:	size_t - size in bytes for skipping
+
+size_t acpi_exec_reset(void *data, acpi_state_t *state)
+{
+	uint8_t *opcode = (uint8_t*)data;
+	size_t name_size;
+	acpi_event_t *event = acpi_exec_event(&opcode[2], &name_size);	// skip EXTOP_PREFIX and RESET_OP
+
+	acpi_reset_event(event);
+	return name_size + 2;
+}
@@ -0,0 +1,89 @@
+
+/*
+ * Lux ACPI Implementation
+ * Copyright (C) 2018 by Omar Mohammad
+ */
+
+/* Timing Functions */
+/* Timer() counts in 100 ns units and Stall() waits for microseconds, both
+ * far finer than the milliseconds of acpi_sleep(). They read acpi_timer(),
+ * which the OS can back with a TSC it calibrated itself, or with the ACPI
+ * PM timer through acpi_pm_timer() below. */
+
+#include "lai.h"
+
+acpi_lock_t acpi_pm_timer_lock;
+uint32_t acpi_pm_timer_last;		// last value read from the hardware
+uint64_t acpi_pm_timer_ticks;		// ticks before it, counting every wrap
+
+// acpi_pm_timer(): Reads the FADT PM timer as a monotonic counter
+// Param:	Nothing
+// Return:	uint64_t - time in 100 ns units, for OSes to return from acpi_timer()
+
+uint64_t acpi_pm_timer()
+{
+	uint32_t value, mask;
+	uint64_t ticks;
+
+	// the counter is only 24 bits wide unless TMR_VAL_EXT is set, which
+	// wraps every 4.7 seconds, so it must be read at least that often
+	if(acpi_fadt->flags & ACPI_TIMER_32BIT)
+		mask = 0xFFFFFFFF;
+	else
+		mask = 0xFFFFFF;
+
+	ACPI_LOCK(&acpi_pm_timer_lock);
+	value = acpi_ind(acpi_fadt->pm_timer_block) & mask;
+	acpi_pm_timer_ticks += (value - acpi_pm_timer_last) & mask;
+	acpi_pm_timer_last = value;
+	ticks = acpi_pm_timer_ticks;
+	ACPI_UNLOCK(&acpi_pm_timer_lock);
+
+	// split, so that ticks * 10000000 can't overflow
+	return (ticks / ACPI_PM_TIMER_FREQUENCY) * 10000000
+		+ (ticks % ACPI_PM_TIMER_FREQUENCY) * 10000000 / ACPI_PM_TIMER_FREQUENCY;
+}
+
+// acpi_stall(): Busy-waits, for Stall()
+// Param:	uint64_t microseconds - time to wait
+// Return:	Nothing
+
+void acpi_stall(uint64_t microseconds)
+{
+	uint64_t end = acpi_timer() + microseconds * 10;
+
+	// firmware stalls for hardware handshakes, which are too short for
+	// acpi_sleep() to give up the CPU
+	while(acpi_timer() < end);
+}
+
+// acpi_exec_stall(): Executes a Stall() opcode
+// Param:	void *data - opcode data
+// Param:	acpi_state_t *state - AML VM state
+// Return:	size_t - size in bytes for skipping
+
+size_t acpi_exec_stall(void *data, acpi_state_t *state)
+{
+	size_t return_size = 2;
+	uint8_t *opcode = (uint8_t*)data;
+	opcode += 2;		// skip EXTOP_PREFIX and STALL_OP
+
+	acpi_object_t time;
+	return_size += acpi_eval_object(&time, state, &opcode[0]);
+
+	acpi_stall(time.integer);
+	return return_size;
+}
+
+// acpi_eval_timer(): Evaluates a Timer opcode
+// Param:	acpi_object_t *destination - where to store the time
+// Param:	acpi_state_t *state - AML VM state
+// Param:	void *data - opcode data
+// Return:	size_t - size in bytes for skipping
+
+size_t acpi_eval_timer(acpi_object_t *destination, acpi_state_t *state, void *data)
+{
+	destination->type = ACPI_INTEGER;
+	destination->integer = acpi_timer();
+	return 2;		// EXTOP_PREFIX and TIMER_OP
+}
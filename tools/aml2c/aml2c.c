@@ -0,0 +1,854 @@
+
+/*
+ * Lux ACPI Implementation
+ * Copyright (C) 2018 by Omar Mohammad
+ */
+
+/* Ahead-of-time compiler from AML to C */
+/* Host tool for platforms whose firmware is known in advance. It builds the
+ * namespace of a DSDT and its SSDTs with lai's own parser, compiles every
+ * control method into IR like the runtime would, and writes both out as C:
+ * the AML itself, a static namespace that points into it, and one function per
+ * method. The operand stack depth is known for every IR instruction, so the
+ * functions work on fixed stack slots and jump with goto. The output links
+ * against lai, which still does OpRegions, OS services, and anything left in
+ * AML; acpi_aot_create_namespace() replaces acpi_create_namespace() at boot.
+ * Methods the compiler can't handle are left to the interpreter as usual.
+ *
+ * Build:	cc -I tools/aml2c -I src src/[a-z]*.c tools/aml2c/aml2c.c -o aml2c
+ * Usage:	aml2c -o dsdt.c dsdt.aml [ssdt1.aml ...] */
+
+#include <lai.h>
+#include <string.h>
+
+#define AML2C_MAX_TABLES		32
+
+acpi_aml_t *aml2c_tables[AML2C_MAX_TABLES];
+const char *aml2c_names[AML2C_MAX_TABLES];
+size_t aml2c_table_count = 0;
+extern uint8_t *acpi_acpins_code;
+extern size_t acpi_acpins_size;
+
+acpi_aml_t *aml2c_load(const char *);
+void aml2c_string(FILE *, const char *);
+void aml2c_aml_pointer(FILE *, void *);
+int aml2c_depths(acpi_ir_t *, size_t *);
+int aml2c_method(FILE *, size_t);
+void aml2c_branch(FILE *, acpi_ir_t *, size_t, size_t);
+void aml2c_op(FILE *, size_t, size_t, acpi_irop_t *, size_t);
+void aml2c_handle(FILE *, size_t, int);
+
+/* Hosted OS functions, the tool never touches hardware */
+
+// acpi_scan(): Finds an ACPI table among the ones given on the command line
+// Param:	char *signature - table signature, only SSDTs are looked up this way
+// Param:	size_t index - index among the tables with that signature
+// Return:	void * - the table, NULL if there aren't that many
+
+void *acpi_scan(char *signature, size_t index)
+{
+	size_t i;
+
+	// SSDTs are whatever came after the DSDT, in order
+	if(acpi_memcmp(signature, "SSDT", 4) != 0)
+		return NULL;
+
+	for(i = 1; i < aml2c_table_count; i++)
+	{
+		if(!index)
+			return aml2c_tables[i];
+
+		index--;
+	}
+
+	return NULL;
+}
+
+void *acpi_memcpy(void *dest, const void *src, size_t count) { return memcpy(dest, src, count); }
+void *acpi_memmove(void *dest, const void *src, size_t count) { return memmove(dest, src, count); }
+void *acpi_malloc(size_t count) { return malloc(count); }
+void *acpi_calloc(size_t n, size_t size) { return calloc(n, size); }
+void *acpi_realloc(void *ptr, size_t count) { return realloc(ptr, count); }
+void acpi_free(void *ptr) { free(ptr); }
+char *acpi_strcpy(char *dest, const char *src) { return strcpy(dest, src); }
+size_t acpi_strlen(const char *string) { return strlen(string); }
+void *acpi_memset(void *dest, int val, size_t count) { return memset(dest, val, count); }
+int acpi_strcmp(const char *s1, const char *s2) { return strcmp(s1, s2); }
+int acpi_memcmp(const char *m1, const char *m2, size_t count) { return memcmp(m1, m2, count); }
+
+void *acpi_map(size_t physical, size_t count)
+{
+	acpi_panic("aml2c: AML touched memory at 0x%zx while building the namespace\n", physical);
+}
+
+void acpi_outb(uint16_t port, uint8_t data) { acpi_panic("aml2c: AML touched I/O port 0x%x\n", port); }
+void acpi_outw(uint16_t port, uint16_t data) { acpi_panic("aml2c: AML touched I/O port 0x%x\n", port); }
+void acpi_outd(uint16_t port, uint32_t data) { acpi_panic("aml2c: AML touched I/O port 0x%x\n", port); }
+uint8_t acpi_inb(uint16_t port) { acpi_panic("aml2c: AML touched I/O port 0x%x\n", port); }
+uint16_t acpi_inw(uint16_t port) { acpi_panic("aml2c: AML touched I/O port 0x%x\n", port); }
+uint32_t acpi_ind(uint16_t port) { acpi_panic("aml2c: AML touched I/O port 0x%x\n", port); }
+void acpi_pci_write(uint8_t bus, uint8_t slot, uint8_t function, uint16_t offset, uint32_t data) { acpi_panic("aml2c: AML touched PCI\n"); }
+uint32_t acpi_pci_read(uint8_t bus, uint8_t slot, uint8_t function, uint16_t offset) { acpi_panic("aml2c: AML touched PCI\n"); }
+void acpi_sleep(uint64_t time) { }
+uint64_t acpi_timer() { acpi_panic("aml2c: AML read the timer\n"); }
+
+// main(): Translates the methods of a DSDT and its SSDTs into a C file
+// Param:	int argc - argument count
+// Param:	char **argv - -o with the output file, then the DSDT and SSDTs
+// Return:	int - 0 on success
+
+int main(int argc, char **argv)
+{
+	const char *output = NULL;
+	FILE *file;
+	size_t i;
+	int j;
+
+	for(j = 1; j < argc; j++)
+	{
+		if(!strcmp(argv[j], "-o") && j + 1 < argc)
+		{
+			j++;
+			output = argv[j];
+		} else if(aml2c_table_count < AML2C_MAX_TABLES)
+		{
+			aml2c_tables[aml2c_table_count] = aml2c_load(argv[j]);
+			aml2c_names[aml2c_table_count] = argv[j];
+			aml2c_table_count++;
+		} else
+		{
+			acpi_panic("aml2c: more than %d tables\n", AML2C_MAX_TABLES);
+		}
+	}
+
+	if(!output || !aml2c_table_count)
+	{
+		fprintf(stderr, "usage: %s -o output.c dsdt.aml [ssdt.aml ...]\n", argv[0]);
+		return 1;
+	}
+
+	acpi_create_namespace(aml2c_tables[0]);
+
+	file = fopen(output, "w");
+	if(!file)
+	{
+		acpi_panic("aml2c: can't write %s\n", output);
+	}
+
+	fprintf(file, "\n/* Generated by aml2c from %s", aml2c_names[0]);
+	for(i = 1; i < aml2c_table_count; i++)
+		fprintf(file, ", %s", aml2c_names[i]);
+	fprintf(file, ", don't edit */\n\n#include <lai.h>\n\n");
+
+	// all the tables, back to back like acpins_load_table() keeps them
+	fprintf(file, "uint8_t acpi_aot_aml[%zu] = {", acpi_acpins_size);
+	for(i = 0; i < acpi_acpins_size; i++)
+		fprintf(file, "%s0x%02x,", (i % 16) ? " " : "\n\t", acpi_acpins_code[i]);
+	fprintf(file, "\n};\n\n");
+
+	int *native = calloc(acpi_namespace_entries, sizeof(int));
+	for(i = 0; i < acpi_namespace_entries; i++)
+	{
+		if(ACPI_HANDLE(i)->type == ACPI_NAMESPACE_METHOD && ACPI_HANDLE(i)->pointer)
+			native[i] = !aml2c_method(file, i);
+	}
+
+	// mutexes and events change at run time, so they live outside the
+	// namespace; this includes the mutexes of Serialized methods
+	for(i = 0; i < acpi_namespace_entries; i++)
+	{
+		if(ACPI_HANDLE(i)->mutex)
+			fprintf(file, "acpi_mutex_t acpi_aot_mutex_%zu = { .sync_level = %d };\n", i, ACPI_HANDLE(i)->mutex->sync_level);
+		if(ACPI_HANDLE(i)->event)
+			fprintf(file, "acpi_event_t acpi_aot_event_%zu;\n", i);
+	}
+	fprintf(file, "\n");
+
+	fprintf(file, "acpi_handle_t acpi_aot_namespace[%zu] =\n{\n", acpi_namespace_entries);
+	for(i = 0; i < acpi_namespace_entries; i++)
+		aml2c_handle(file, i, native[i]);
+	fprintf(file, "};\n\n");
+
+	fprintf(file, "// acpi_aot_create_namespace(): Installs the namespace of the tables above\n");
+	fprintf(file, "// Param:\tNothing\n// Return:\tNothing\n\n");
+	fprintf(file, "void acpi_aot_create_namespace()\n{\n");
+	fprintf(file, "\tacpi_load_namespace(acpi_aot_namespace, %zu, acpi_aot_aml, %zu);\n}\n", acpi_namespace_entries, acpi_acpins_size);
+
+	fclose(file);
+	free(native);
+	return 0;
+}
+
+// aml2c_load(): Reads an AML table from a file
+// Param:	const char *path - file name
+// Return:	acpi_aml_t * - table
+
+acpi_aml_t *aml2c_load(const char *path)
+{
+	FILE *file = fopen(path, "rb");
+	long size;
+	acpi_aml_t *table;
+
+	if(!file)
+	{
+		acpi_panic("aml2c: can't read %s\n", path);
+	}
+
+	fseek(file, 0, SEEK_END);
+	size = ftell(file);
+	fseek(file, 0, SEEK_SET);
+
+	table = malloc(size);
+	if(size < (long)sizeof(acpi_header_t) || fread(table, 1, size, file) != (size_t)size || table->header.length > (uint32_t)size)
+	{
+		acpi_panic("aml2c: %s is not an AML table\n", path);
+	}
+
+	fclose(file);
+	return table;
+}
+
+// aml2c_string(): Writes a C string literal
+// Param:	FILE *file - output
+// Param:	const char *string - string
+// Return:	Nothing
+
+void aml2c_string(FILE *file, const char *string)
+{
+	fputc('"', file);
+	while(*string)
+	{
+		if(*string == '\\' || *string == '"')
+			fprintf(file, "\\%c", *string);
+		else if(*string < 0x20 || *string > 0x7E)
+			fprintf(file, "\\%03o", (uint8_t)*string);
+		else
+			fputc(*string, file);
+
+		string++;
+	}
+	fputc('"', file);
+}
+
+// aml2c_aml_pointer(): Writes a pointer into the AML as an address constant
+// Param:	FILE *file - output
+// Param:	void *pointer - pointer into acpi_acpins_code
+// Return:	Nothing
+
+void aml2c_aml_pointer(FILE *file, void *pointer)
+{
+	size_t offset = (size_t)((uint8_t*)pointer - acpi_acpins_code);
+
+	if(!pointer)
+		fprintf(file, "NULL");
+	else if((uint8_t*)pointer < acpi_acpins_code || offset >= acpi_acpins_size)
+	{
+		acpi_panic("aml2c: pointer %p is outside the AML\n", pointer);
+	} else
+		fprintf(file, "&acpi_aot_aml[%zu]", offset);
+}
+
+// aml2c_depths(): Works out the operand stack depth before every instruction
+// Param:	acpi_ir_t *ir - compiled method
+// Param:	size_t *depth - one per instruction and one for the end, (size_t)-1 until known
+// Return:	int - 0 if the depths are the same on every path
+
+int aml2c_depths(acpi_ir_t *ir, size_t *depth)
+{
+	acpi_irop_t *op;
+	size_t sp = 0, ip, pops, pushes;
+	int reachable = 1;
+
+	for(ip = 0; ip <= ir->count; ip++)
+	{
+		if(!reachable)
+		{
+			// nothing falls through, and no jump seen so far lands here
+			if(depth[ip] == (size_t)-1 && ip == ir->count)
+				break;
+			if(depth[ip] == (size_t)-1)
+				return 1;
+			sp = depth[ip];
+		} else if(depth[ip] != (size_t)-1 && depth[ip] != sp)
+			return 1;
+
+		depth[ip] = sp;
+		reachable = 1;
+
+		if(ip == ir->count)
+			break;
+
+		op = &ir->code[ip];
+		pops = 0;
+		pushes = 0;
+
+		switch(op->opcode)
+		{
+		case ACPI_IR_INTEGER:
+		case ACPI_IR_STRING:
+		case ACPI_IR_LOCAL:
+		case ACPI_IR_ARG:
+		case ACPI_IR_NAME:
+		case ACPI_IR_AML:
+		case ACPI_IR_CONDREF:
+		case ACPI_IR_TIMER:
+		case ACPI_IR_ACQUIRE:
+			pushes = 1;
+			break;
+
+		case ACPI_IR_INVOKE:
+			pops = op->index;
+			pushes = 1;
+			break;
+
+		case ACPI_IR_STACK:
+			if(op->index >= sp)
+				return 1;
+			pushes = 1;
+			break;
+
+		case ACPI_IR_SLIDE:
+			pops = op->index + 1;
+			pushes = 1;
+			break;
+
+		case ACPI_IR_STORE_LOCAL:
+		case ACPI_IR_STORE_ARG:
+		case ACPI_IR_STORE_NAME:
+		case ACPI_IR_SIZEOF:
+		case ACPI_IR_WAIT:
+		case ACPI_IR_INCREMENT:
+		case ACPI_IR_DECREMENT:
+		case ACPI_IR_NOT:
+		case ACPI_IR_LNOT:
+		case ACPI_IR_SHR_AND:
+			pops = 1;
+			pushes = 1;
+			break;
+
+		case ACPI_IR_DIVIDE:
+			pops = 2;
+			pushes = 2;
+			break;
+
+		case ACPI_IR_STORE_INDEX:
+			pops = 2;
+			pushes = 1;
+			break;
+
+		case ACPI_IR_POP:
+		case ACPI_IR_SET_LOCAL:
+		case ACPI_IR_DEFINE_NAME:
+		case ACPI_IR_SLEEP:
+		case ACPI_IR_STALL:
+		case ACPI_IR_JUMP_ZERO:
+			pops = 1;
+			break;
+
+		case ACPI_IR_RETURN:
+			pops = 1;
+			reachable = 0;
+			break;
+
+		case ACPI_IR_EXEC:
+		case ACPI_IR_RELEASE:
+		case ACPI_IR_SIGNAL:
+		case ACPI_IR_RESET:
+		case ACPI_IR_NAME_TO_LOCAL:
+		case ACPI_IR_INCREMENT_LOCAL:
+		case ACPI_IR_DECREMENT_LOCAL:
+		case ACPI_IR_JUMP:
+		case ACPI_IR_JUMP_LOCAL_NE:
+		case ACPI_IR_JUMP_LOCAL_GE:
+		case ACPI_IR_JUMP_LOCAL_LE:
+			break;
+
+		default:
+			// everything left takes two integers and returns one
+			pops = 2;
+			pushes = 1;
+			break;
+		}
+
+		if(sp < pops)
+			return 1;
+		sp = sp - pops + pushes;
+
+		switch(op->opcode)
+		{
+		case ACPI_IR_JUMP:
+			reachable = 0;
+			// fall through
+		case ACPI_IR_JUMP_ZERO:
+		case ACPI_IR_JUMP_LOCAL_NE:
+		case ACPI_IR_JUMP_LOCAL_GE:
+		case ACPI_IR_JUMP_LOCAL_LE:
+			if(op->target > ir->count)
+				return 1;
+			if(depth[op->target] != (size_t)-1 && depth[op->target] != sp)
+				return 1;
+
+			depth[op->target] = sp;
+			break;
+		}
+	}
+
+	return 0;
+}
+
+// aml2c_method(): Writes a control method as a C function
+// Param:	FILE *file - output
+// Param:	size_t index - namespace index of the method
+// Return:	int - 0 on success, 1 if the method is left to the interpreter
+
+int aml2c_method(FILE *file, size_t index)
+{
+	acpi_handle_t *method = ACPI_HANDLE(index);
+	acpi_ir_t *ir = acpi_compile_method(method);
+	acpi_irop_t *op;
+	size_t *depth;
+	uint8_t *target;
+	size_t ip;
+
+	if(!ir)
+	{
+		acpi_printf("aml2c: %s stays in AML\n", method->path);
+		return 1;
+	}
+
+	depth = malloc((ir->count + 1) * sizeof(size_t));
+	target = calloc(ir->count + 1, 1);
+	for(ip = 0; ip <= ir->count; ip++)
+		depth[ip] = (size_t)-1;
+
+	if(aml2c_depths(ir, depth))
+	{
+		acpi_printf("aml2c: %s stays in IR, its stack depth varies\n", method->path);
+		free(depth);
+		free(target);
+		return 1;
+	}
+
+	// the instructions themselves are still needed, for names and AML fallbacks
+	fprintf(file, "// %s\n", method->path);
+	fprintf(file, "static acpi_irop_t acpi_aot_ops_%zu[] =\n{\n", index);
+	for(ip = 0; ip < ir->count; ip++)
+	{
+		op = &ir->code[ip];
+		fprintf(file, "\t{ .opcode = %d, .index = %d, .target = %u, .integer = 0x%llxULL, .aml = ", op->opcode, op->index, op->target, (unsigned long long)op->integer);
+
+		// folded _OS_ points at the runtime's own string
+		if(op->aml == (uint8_t*)acpi_emulated_os)
+			fprintf(file, "(uint8_t*)acpi_emulated_os");
+		else
+			aml2c_aml_pointer(file, op->aml);
+
+		fprintf(file, ", .name = ");
+		if(op->name)
+			aml2c_string(file, op->name);
+		else
+			fprintf(file, "NULL");
+		fprintf(file, " },\n");
+
+		if(op->opcode == ACPI_IR_JUMP || op->opcode == ACPI_IR_JUMP_ZERO || op->opcode == ACPI_IR_JUMP_LOCAL_NE
+			|| op->opcode == ACPI_IR_JUMP_LOCAL_GE || op->opcode == ACPI_IR_JUMP_LOCAL_LE)
+		{
+			// 2 for the heads of loops
+			if(op->target <= ip)
+				target[op->target] = 2;
+			else if(!target[op->target])
+				target[op->target] = 1;
+		}
+	}
+
+	fprintf(file, "\t{ 0 }\n};\n\n");
+
+	fprintf(file, "static int acpi_aot_method_%zu(acpi_state_t *state, acpi_object_t *method_return)\n{\n", index);
+	fprintf(file, "\tacpi_irop_t *op = acpi_aot_ops_%zu;\n", index);
+	fprintf(file, "\tacpi_object_t s[%zu];\n", ir->stack_size + 1);
+	fprintf(file, "\tacpi_state_t *invoke;\n\tuint64_t t;\n\n");
+	fprintf(file, "\t(void)op; (void)invoke; (void)t;\n");
+	fprintf(file, "\tacpi_strcpy(acpi_context()->path, state->name);\n");
+	fprintf(file, "\tacpi_context()->scope = state->scope;\n");
+	fprintf(file, "\tstate->arg_count = %d;\n\tstate->local_count = %d;\n\n", ir->arg_count, ir->local_count);
+
+	for(ip = 0; ip < ir->count; ip++)
+	{
+		if(target[ip])
+			fprintf(file, "l%zu:\n", ip);
+		if(target[ip] == 2)
+			aml2c_branch(file, ir, ip, depth[ip]);
+
+		aml2c_op(file, ip, depth[ip], &ir->code[ip], index);
+	}
+
+	// when it returns nothing, assume Return (0)
+	if(depth[ir->count] != (size_t)-1)
+	{
+		if(target[ir->count])
+			fprintf(file, "l%zu:\n", ir->count);
+		fprintf(file, "\tmethod_return->type = ACPI_INTEGER;\n\tmethod_return->integer = 0;\n\treturn 0;\n");
+	}
+
+	fprintf(file, "}\n\n");
+
+	free(depth);
+	free(target);
+	return 0;
+}
+
+// aml2c_branch(): Writes the budget check at the head of a loop, for runtimes built with ACPI_BUDGET
+// Param:	FILE *file - output
+// Param:	acpi_ir_t *ir - compiled method
+// Param:	size_t head - index of the first instruction of the loop
+// Param:	size_t d - operand stack depth there
+// Return:	Nothing
+
+void aml2c_branch(FILE *file, acpi_ir_t *ir, size_t head, size_t d)
+{
+	acpi_irop_t *op;
+	size_t i, length = 0;
+
+	// the C doesn't count instructions, so every iteration is charged
+	// for the whole loop up to the last jump back here
+	for(i = head; i < ir->count; i++)
+	{
+		op = &ir->code[i];
+		if(op->opcode != ACPI_IR_JUMP && op->opcode != ACPI_IR_JUMP_ZERO && op->opcode != ACPI_IR_JUMP_LOCAL_NE
+			&& op->opcode != ACPI_IR_JUMP_LOCAL_GE && op->opcode != ACPI_IR_JUMP_LOCAL_LE)
+			continue;
+
+		if(op->target == head)
+			length = i - head + 1;
+	}
+
+	fprintf(file, "#ifdef ACPI_BUDGET\n\tif(acpi_budget_branch(%zu))\n\t{\n", length);
+	for(i = 0; i < d; i++)
+		fprintf(file, "\t\tacpi_free_object(&s[%zu]);\n", i);
+	fprintf(file, "\t\tmethod_return->type = ACPI_INTEGER;\n\t\tmethod_return->integer = 0;\n\t\treturn ACPI_ABORTED;\n\t}\n#endif\n");
+}
+
+// aml2c_op(): Writes the C for one IR instruction
+// Param:	FILE *file - output
+// Param:	size_t ip - index of the instruction
+// Param:	size_t d - operand stack depth before it
+// Param:	acpi_irop_t *op - instruction
+// Param:	size_t method - namespace index of the method, for messages
+// Return:	Nothing
+
+void aml2c_op(FILE *file, size_t ip, size_t d, acpi_irop_t *op, size_t method)
+{
+	const char *symbol = NULL;
+	size_t i;
+
+	switch(op->opcode)
+	{
+	case ACPI_IR_INTEGER:
+		fprintf(file, "\ts[%zu].type = ACPI_INTEGER;\n\ts[%zu].integer = 0x%llxULL;\n", d, d, (unsigned long long)op->integer);
+		return;
+
+	case ACPI_IR_STRING:
+		fprintf(file, "\ts[%zu].type = ACPI_STRING;\n\ts[%zu].string = (char*)op[%zu].aml;\n", d, d, ip);
+		return;
+
+	case ACPI_IR_LOCAL:
+		fprintf(file, "\tacpi_copy_object(&s[%zu], &state->local[%d]);\n", d, op->index);
+		return;
+
+	case ACPI_IR_ARG:
+		fprintf(file, "\tacpi_copy_object(&s[%zu], &state->arg[%d]);\n", d, op->index);
+		return;
+
+	case ACPI_IR_NAME:
+		fprintf(file, "\tacpi_ir_read_name(&s[%zu], &op[%zu]);\n", d, ip);
+		return;
+
+	case ACPI_IR_AML:
+		fprintf(file, "\tacpi_eval_object(&s[%zu], state, op[%zu].aml);\n", d, ip);
+		return;
+
+	case ACPI_IR_INVOKE:
+		fprintf(file, "\tinvoke = acpi_push_state(op[%zu].name);\n", ip);
+		for(i = 0; i < op->index; i++)
+			fprintf(file, "\tinvoke->arg[%zu] = s[%zu];\n", i, d - op->index + i);
+		fprintf(file, "\tacpi_exec_method(invoke, &s[%zu]);\n", d - op->index);
+		fprintf(file, "\tacpi_strcpy(acpi_context()->path, state->name);\n");
+		fprintf(file, "\tacpi_context()->scope = state->scope;\n\tacpi_pop_state(invoke);\n");
+		return;
+
+	case ACPI_IR_STORE_LOCAL:
+		fprintf(file, "\tacpi_replace_object(&state->local[%d], &s[%zu]);\n", op->index, d - 1);
+		return;
+
+	case ACPI_IR_STORE_ARG:
+		fprintf(file, "\tacpi_replace_object(&state->arg[%d], &s[%zu]);\n", op->index, d - 1);
+		return;
+
+	case ACPI_IR_STORE_NAME:
+		fprintf(file, "\tacpi_ir_write_name(&op[%zu], &s[%zu]);\n", ip, d - 1);
+		return;
+
+	case ACPI_IR_STORE_INDEX:
+		fprintf(file, "\tacpi_ir_store_index(&op[%zu], state, s[%zu].integer, &s[%zu]);\n", ip, d - 1, d - 2);
+		return;
+
+	case ACPI_IR_DEFINE_NAME:
+		fprintf(file, "\tacpi_ir_define_name(&op[%zu], &s[%zu]);\n", ip, d - 1);
+		return;
+
+	case ACPI_IR_EXEC:
+		fprintf(file, "\tacpi_ir_create_field(&op[%zu], state);\n", ip);
+		return;
+
+	case ACPI_IR_POP:
+		fprintf(file, "\tacpi_free_object(&s[%zu]);\n", d - 1);
+		return;
+
+	case ACPI_IR_JUMP:
+		fprintf(file, "\tgoto l%u;\n", op->target);
+		return;
+
+	case ACPI_IR_JUMP_ZERO:
+		fprintf(file, "\tt = s[%zu].integer;\n\tacpi_free_object(&s[%zu]);\n\tif(!t)\n\t\tgoto l%u;\n", d - 1, d - 1, op->target);
+		return;
+
+	case ACPI_IR_RETURN:
+		fprintf(file, "\tmethod_return[0] = s[%zu];\n\treturn 0;\n", d - 1);
+		return;
+
+	case ACPI_IR_SLEEP:
+		fprintf(file, "\tacpi_sleep(s[%zu].integer);\n", d - 1);
+		return;
+
+	case ACPI_IR_STALL:
+		fprintf(file, "\tacpi_stall(s[%zu].integer);\n", d - 1);
+		return;
+
+	case ACPI_IR_TIMER:
+		fprintf(file, "\ts[%zu].type = ACPI_INTEGER;\n\ts[%zu].integer = acpi_timer();\n", d, d);
+		return;
+
+	case ACPI_IR_ACQUIRE:
+		fprintf(file, "\ts[%zu].type = ACPI_INTEGER;\n\ts[%zu].integer = acpi_acquire_mutex(acpi_ir_mutex(&op[%zu]), 0x%llx);\n", d, d, ip, (unsigned long long)op->integer);
+		return;
+
+	case ACPI_IR_RELEASE:
+		fprintf(file, "\tacpi_release_mutex(acpi_ir_mutex(&op[%zu]));\n", ip);
+		return;
+
+	case ACPI_IR_WAIT:
+		fprintf(file, "\ts[%zu].type = ACPI_INTEGER;\n\ts[%zu].integer = acpi_wait_event(acpi_ir_event(&op[%zu]), s[%zu].integer);\n", d - 1, d - 1, ip, d - 1);
+		return;
+
+	case ACPI_IR_SIGNAL:
+		fprintf(file, "\tacpi_signal_event(acpi_ir_event(&op[%zu]));\n", ip);
+		return;
+
+	case ACPI_IR_RESET:
+		fprintf(file, "\tacpi_reset_event(acpi_ir_event(&op[%zu]));\n", ip);
+		return;
+
+	case ACPI_IR_CONDREF:
+		fprintf(file, "\ts[%zu].type = ACPI_INTEGER;\n\ts[%zu].integer = acpi_ir_resolve(&op[%zu]) ? 1 : 0;\n", d, d, ip);
+		return;
+
+	case ACPI_IR_SIZEOF:
+		fprintf(file, "\tacpi_ir_sizeof(&s[%zu]);\n", d - 1);
+		return;
+
+	case ACPI_IR_INDEX:
+		fprintf(file, "\tacpi_ir_index(&s[%zu], s[%zu].integer);\n", d - 2, d - 1);
+		return;
+
+	/* Superinstructions */
+	case ACPI_IR_SET_LOCAL:
+		fprintf(file, "\tacpi_free_object(&state->local[%d]);\n\tstate->local[%d] = s[%zu];\n", op->index, op->index, d - 1);
+		return;
+
+	case ACPI_IR_NAME_TO_LOCAL:
+		fprintf(file, "\tacpi_ir_read_name(&s[%zu], &op[%zu]);\n", d, ip);
+		fprintf(file, "\tacpi_free_object(&state->local[%d]);\n\tstate->local[%d] = s[%zu];\n", op->index, op->index, d);
+		return;
+
+	case ACPI_IR_INCREMENT_LOCAL:
+		fprintf(file, "\tstate->local[%d].integer++;\n", op->index);
+		return;
+
+	case ACPI_IR_DECREMENT_LOCAL:
+		fprintf(file, "\tstate->local[%d].integer--;\n", op->index);
+		return;
+
+	case ACPI_IR_JUMP_LOCAL_NE:
+	case ACPI_IR_JUMP_LOCAL_GE:
+	case ACPI_IR_JUMP_LOCAL_LE:
+		if(op->opcode == ACPI_IR_JUMP_LOCAL_NE)
+			symbol = "!=";
+		else if(op->opcode == ACPI_IR_JUMP_LOCAL_GE)
+			symbol = ">=";
+		else
+			symbol = "<=";
+
+		fprintf(file, "\tif(state->local[%d].integer %s 0x%llxULL)\n\t\tgoto l%u;\n", op->index, symbol, (unsigned long long)op->integer, op->target);
+		return;
+
+	case ACPI_IR_SHR_AND:
+		fprintf(file, "\ts[%zu].type = ACPI_INTEGER;\n\ts[%zu].integer = (s[%zu].integer >> %d) & 0x%llxULL;\n", d - 1, d - 1, d - 1, op->index, (unsigned long long)op->integer);
+		return;
+
+	/* Inlined methods */
+	case ACPI_IR_STACK:
+		fprintf(file, "\tacpi_copy_object(&s[%zu], &s[%d]);\n", d, op->index);
+		return;
+
+	case ACPI_IR_SLIDE:
+		for(i = 0; i < op->index; i++)
+			fprintf(file, "\tacpi_free_object(&s[%zu]);\n", d - 1 - op->index + i);
+		fprintf(file, "\ts[%zu] = s[%zu];\n", d - 1 - op->index, d - 1);
+		return;
+
+	/* Arithmetic */
+	case ACPI_IR_INCREMENT:
+		fprintf(file, "\ts[%zu].integer++;\n", d - 1);
+		return;
+
+	case ACPI_IR_DECREMENT:
+		fprintf(file, "\ts[%zu].integer--;\n", d - 1);
+		return;
+
+	case ACPI_IR_NOT:
+		fprintf(file, "\ts[%zu].type = ACPI_INTEGER;\n\ts[%zu].integer = ~s[%zu].integer;\n", d - 1, d - 1, d - 1);
+		return;
+
+	case ACPI_IR_LNOT:
+		fprintf(file, "\ts[%zu].type = ACPI_INTEGER;\n\ts[%zu].integer = (s[%zu].integer == 0) ? 1 : 0;\n", d - 1, d - 1, d - 1);
+		return;
+
+	case ACPI_IR_DIVIDE:
+		fprintf(file, "\tif(s[%zu].integer == 0)\n\t{\n\t\tacpi_panic(\"acpi: divide by zero in control method %%s\\n\", state->name);\n\t}\n", d - 1);
+		fprintf(file, "\tt = s[%zu].integer / s[%zu].integer;\n", d - 2, d - 1);
+		fprintf(file, "\ts[%zu].integer = s[%zu].integer %% s[%zu].integer;\n", d - 1, d - 2, d - 1);
+		fprintf(file, "\ts[%zu].type = ACPI_INTEGER;\n\ts[%zu].integer = t;\n\ts[%zu].type = ACPI_INTEGER;\n", d - 2, d - 2, d - 1);
+		return;
+
+	case ACPI_IR_ADD: symbol = "+"; break;
+	case ACPI_IR_SUBTRACT: symbol = "-"; break;
+	case ACPI_IR_MULTIPLY: symbol = "*"; break;
+	case ACPI_IR_AND: symbol = "&"; break;
+	case ACPI_IR_OR: symbol = "|"; break;
+	case ACPI_IR_XOR: symbol = "^"; break;
+	case ACPI_IR_SHL: symbol = "<<"; break;
+	case ACPI_IR_SHR: symbol = ">>"; break;
+
+	case ACPI_IR_LAND:
+		fprintf(file, "\ts[%zu].integer = (s[%zu].integer != 0 && s[%zu].integer != 0) ? 1 : 0;\n", d - 2, d - 2, d - 1);
+		fprintf(file, "\ts[%zu].type = ACPI_INTEGER;\n", d - 2);
+		return;
+
+	case ACPI_IR_LOR:
+		fprintf(file, "\ts[%zu].integer = (s[%zu].integer != 0 || s[%zu].integer != 0) ? 1 : 0;\n", d - 2, d - 2, d - 1);
+		fprintf(file, "\ts[%zu].type = ACPI_INTEGER;\n", d - 2);
+		return;
+
+	case ACPI_IR_LEQUAL: symbol = "=="; break;
+	case ACPI_IR_LGREATER: symbol = ">"; break;
+	case ACPI_IR_LLESS: symbol = "<"; break;
+
+	default:
+		acpi_panic("aml2c: undefined IR opcode %d in control method %s\n", op->opcode, ACPI_HANDLE(method)->path);
+	}
+
+	// the comparisons return 1 or 0, the rest an integer
+	if(op->opcode == ACPI_IR_LEQUAL || op->opcode == ACPI_IR_LGREATER || op->opcode == ACPI_IR_LLESS)
+		fprintf(file, "\ts[%zu].integer = (s[%zu].integer %s s[%zu].integer) ? 1 : 0;\n", d - 2, d - 2, symbol, d - 1);
+	else
+		fprintf(file, "\ts[%zu].integer = s[%zu].integer %s s[%zu].integer;\n", d - 2, d - 2, symbol, d - 1);
+
+	fprintf(file, "\ts[%zu].type = ACPI_INTEGER;\n", d - 2);
+}
+
+// aml2c_handle(): Writes the initializer of a namespace object
+// Param:	FILE *file - output
+// Param:	size_t index - namespace index
+// Param:	int native - 1 if aml2c_method() translated the method
+// Return:	Nothing
+
+void aml2c_handle(FILE *file, size_t index, int native)
+{
+	acpi_handle_t *handle = ACPI_HANDLE(index);
+
+	fprintf(file, "\t{ .path = ");
+	aml2c_string(file, handle->path);
+	fprintf(file, ", .type = %d", handle->type);
+
+	if(handle->pointer)
+	{
+		fprintf(file, ", .pointer = ");
+		aml2c_aml_pointer(file, handle->pointer);
+	}
+
+	if(handle->size)
+		fprintf(file, ", .size = %zu", handle->size);
+
+	if(handle->alias[0])
+	{
+		fprintf(file, ", .alias = ");
+		aml2c_string(file, handle->alias);
+	}
+
+	// packages and buffers are still in the AML, see acpins_load_object()
+	if(handle->type == ACPI_NAMESPACE_NAME && !handle->pointer)
+	{
+		if(handle->object.type == ACPI_INTEGER)
+			fprintf(file, ", .object = { .type = ACPI_INTEGER, .integer = 0x%llxULL }", (unsigned long long)handle->object.integer);
+		else if(handle->object.type == ACPI_STRING)
+		{
+			fprintf(file, ", .object = { .type = ACPI_STRING, .string = (char*)");
+			aml2c_aml_pointer(file, handle->object.string);
+			fprintf(file, " }");
+		} else
+		{
+			acpi_panic("aml2c: Name() %s has object type %d\n", handle->path, handle->object.type);
+		}
+	}
+
+	if(handle->type == ACPI_NAMESPACE_FIELD || handle->type == ACPI_NAMESPACE_INDEXFIELD || handle->op_address_space || handle->op_base || handle->op_length)
+	{
+		fprintf(file, ",\n\t\t.op_address_space = %d, .op_base = 0x%llxULL, .op_length = 0x%llxULL", handle->op_address_space, (unsigned long long)handle->op_base, (unsigned long long)handle->op_length);
+		fprintf(file, ", .field_offset = %llu, .field_size = %d, .field_flags = 0x%x, .field_opregion = ", (unsigned long long)handle->field_offset, handle->field_size, handle->field_flags);
+		aml2c_string(file, handle->field_opregion);
+	}
+
+	if(handle->type == ACPI_NAMESPACE_INDEXFIELD)
+	{
+		fprintf(file, ",\n\t\t.indexfield_offset = %llu, .indexfield_index = ", (unsigned long long)handle->indexfield_offset);
+		aml2c_string(file, handle->indexfield_index);
+		fprintf(file, ", .indexfield_data = ");
+		aml2c_string(file, handle->indexfield_data);
+		fprintf(file, ", .indexfield_flags = 0x%x, .indexfield_size = %d", handle->indexfield_flags, handle->indexfield_size);
+	}
+
+	if(handle->type == ACPI_NAMESPACE_METHOD)
+	{
+		fprintf(file, ", .method_flags = 0x%x", handle->method_flags);
+		if(native)
+			fprintf(file, ", .method_native = acpi_aot_method_%zu", index);
+	}
+
+	if(handle->mutex)
+		fprintf(file, ", .mutex = &acpi_aot_mutex_%zu", index);
+
+	if(handle->event)
+		fprintf(file, ", .event = &acpi_aot_event_%zu", index);
+
+	if(handle->type == ACPI_NAMESPACE_PROCESSOR)
+		fprintf(file, ", .cpu_id = %d", handle->cpu_id);
+
+	if(handle->type == ACPI_NAMESPACE_BUFFER_FIELD)
+	{
+		fprintf(file, ", .buffer = ");
+		aml2c_string(file, handle->buffer);
+		fprintf(file, ", .buffer_offset = %llu, .buffer_size = %llu", (unsigned long long)handle->buffer_offset, (unsigned long long)handle->buffer_size);
+	}
+
+	fprintf(file, " },\n");
+}
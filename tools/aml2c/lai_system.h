@@ -0,0 +1,22 @@
+
+/*
+ * Lux ACPI Implementation
+ * Copyright (C) 2018 by Omar Mohammad
+ */
+
+/* Hosted OS functions, for aml2c */
+
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+// the generated C goes to a file, so messages can go to stderr
+#define acpi_printf(...)	fprintf(stderr, __VA_ARGS__)
+
+#define acpi_panic(...)		fprintf(stderr, __VA_ARGS__); \
+				exit(1);
+
+typedef volatile int acpi_lock_t;